@@ -9,19 +9,19 @@ public:
     Matrix2D t;
     Vector2D s;
 
-    Affine2D();
-    Affine2D( const Affine2D &a );
+    constexpr Affine2D();
+    Affine2D( const Affine2D &a ) = default;
 
-    Affine2D( const Vector2D &shift );
-    Affine2D( const Matrix2D &transformation );
-    Affine2D( const Matrix2D &transformation, const Vector2D &shift );
+    constexpr Affine2D( const Vector2D &shift );
+    constexpr Affine2D( const Matrix2D &transformation );
+    constexpr Affine2D( const Matrix2D &transformation, const Vector2D &shift );
 
-    Affine2D &operator=( const Affine2D &other );
+    Affine2D &operator=( const Affine2D &other ) = default;
 
-    Affine2D operator*( const Affine2D &a ) const;
-    Affine2D &operator*=( const Affine2D &a );
+    constexpr Affine2D operator*( const Affine2D &a ) const;
+    constexpr Affine2D &operator*=( const Affine2D &a );
 
-    Vector2D operator()( const Vector2D &a ) const;
+    constexpr Vector2D operator()( const Vector2D &a ) const;
 
     bool operator==( const Affine2D &a ) const;
     bool operator!=( const Affine2D &a ) const;
@@ -29,4 +29,52 @@ public:
     Affine2D inv() const;
 };
 
-Vector2D operator*( const Matrix2D &a, const Vector2D &b );
+constexpr Vector2D operator*( const Matrix2D &a, const Vector2D &b );
+
+constexpr Affine2D::Affine2D() {}
+
+constexpr Affine2D::Affine2D( const Vector2D &shift ): t( Matrix2D::Identity() ), s( shift ) {}
+
+constexpr Affine2D::Affine2D( const Matrix2D &transformation ): t( transformation ), s() {}
+
+constexpr Affine2D::Affine2D( const Matrix2D &transformation, const Vector2D &shift ): t( transformation ), s( shift ) {}
+
+constexpr Affine2D Affine2D::operator*( const Affine2D &a ) const
+{
+    Affine2D r( *this );
+    r *= a;
+    return r;
+}
+
+constexpr Affine2D &Affine2D::operator*=( const Affine2D &a )
+{
+    s += t * a.s;
+    t *= a.t;
+    return *this;
+}
+
+constexpr Vector2D Affine2D::operator()( const Vector2D &a ) const
+{
+    return t * a + s;
+}
+
+inline bool Affine2D::operator==( const Affine2D &a ) const
+{
+    return ( s == a.s ) && ( t == a.t );
+}
+
+inline bool Affine2D::operator!=( const Affine2D &a ) const
+{
+    return ( s != a.s ) || ( t != a.t );
+}
+
+inline Affine2D Affine2D::inv() const
+{
+    auto tInv = t.inv();
+    return Affine2D( tInv, -tInv * s );
+}
+
+constexpr Vector2D operator*( const Matrix2D &a, const Vector2D &b )
+{
+    return Vector2D( a.a00 * b.x + a.a01 * b.y, a.a10 * b.x + a.a11 * b.y );
+}
@@ -1,57 +1,15 @@
 #include "Affine3D.h"
 
-Affine3D::Affine3D(): t( Matrix3D::Identity() ), s() {}
-
-Affine3D::Affine3D( const Affine3D &other )
-{
-    s = other.s;
-    t = other.t;
-}
-
-Affine3D::Affine3D( const Vector3D &shift ): t( Matrix3D::Identity() ), s( shift ) {}
-
-Affine3D::Affine3D( const Matrix3D &transformation ): t( transformation ), s() {}
-
-Affine3D::Affine3D( const Matrix3D &transformation, const Vector3D &shift ): t( transformation ), s( shift ) {}
-
-Affine3D &Affine3D::operator=( const Affine3D &other )
-{
-    s = other.s;
-    t = other.t;
-    return *this;
-}
-
-Affine3D Affine3D::operator*( const Affine3D &a ) const
-{
-    Affine3D r( *this );
-    r *= a;
-    return r;
-}
-
-Affine3D &Affine3D::operator*=( const Affine3D &a )
-{
-    s += t * a.s;
-    t *= a.t;
-    return *this;
-}
-
-Vector3D Affine3D::operator()( const Vector3D &a ) const
-{
-    return t * a + s;
-}
-
-bool Affine3D::operator==( const Affine3D &a ) const
-{
-    return ( s == a.s ) && ( t == a.t );
-}
-
-bool Affine3D::operator!=( const Affine3D &a ) const
-{
-    return ( s != a.s ) || ( t != a.t );
-}
-
-Affine3D Affine3D::inv() const
-{
-    auto tInv = t.inv();
-    return Affine3D( tInv, -tInv * s );
+void Affine3D::apply( const Vector3D *input, Vector3D *output, size_t count ) const
+{
+    const double a00 = t.a00, a01 = t.a01, a02 = t.a02, s0 = s.x;
+    const double a10 = t.a10, a11 = t.a11, a12 = t.a12, s1 = s.y;
+    const double a20 = t.a20, a21 = t.a21, a22 = t.a22, s2 = s.z;
+
+    transformPoints( input, output, count, [=]( double x, double y, double z, double &rx, double &ry, double &rz )
+    {
+        rx = a00 * x + a01 * y + a02 * z + s0;
+        ry = a10 * x + a11 * y + a12 * z + s1;
+        rz = a20 * x + a21 * y + a22 * z + s2;
+    } );
 }
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstddef>
+
 #include "Matrix3D.h"
 #include "Vector3D.h"
 
@@ -9,22 +11,69 @@ public:
     Matrix3D t;
     Vector3D s;
 
-    Affine3D();
-    Affine3D( const Affine3D &other );
+    constexpr Affine3D();
+    Affine3D( const Affine3D &other ) = default;
+
+    constexpr Affine3D( const Vector3D &shift );
+    constexpr Affine3D( const Matrix3D &transformation );
+    constexpr Affine3D( const Matrix3D &transformation, const Vector3D &shift );
 
-    Affine3D( const Vector3D &shift );
-    Affine3D( const Matrix3D &transformation );
-    Affine3D( const Matrix3D &transformation, const Vector3D &shift );
+    Affine3D &operator=( const Affine3D &other ) = default;
 
-    Affine3D &operator=( const Affine3D &other );
+    constexpr Affine3D operator*( const Affine3D &a ) const;
+    constexpr Affine3D &operator*=( const Affine3D &a );
 
-    Affine3D operator*( const Affine3D &a ) const;
-    Affine3D &operator*=( const Affine3D &a );
+    constexpr Vector3D operator()( const Vector3D &a ) const;
 
-    Vector3D operator()( const Vector3D &a ) const;
+    // Transforms 'count' points, 'output' may be the same array, as 'input'
+    // Points are processed in blocks, which coordinates are kept in separate arrays, large arrays are split between threads
+    void apply( const Vector3D *input, Vector3D *output, size_t count ) const;
 
     bool operator==( const Affine3D &a ) const;
     bool operator!=( const Affine3D &a ) const;
 
     Affine3D inv() const;
 };
+
+constexpr Affine3D::Affine3D(): t( Matrix3D::Identity() ), s() {}
+
+constexpr Affine3D::Affine3D( const Vector3D &shift ): t( Matrix3D::Identity() ), s( shift ) {}
+
+constexpr Affine3D::Affine3D( const Matrix3D &transformation ): t( transformation ), s() {}
+
+constexpr Affine3D::Affine3D( const Matrix3D &transformation, const Vector3D &shift ): t( transformation ), s( shift ) {}
+
+constexpr Affine3D Affine3D::operator*( const Affine3D &a ) const
+{
+    Affine3D r( *this );
+    r *= a;
+    return r;
+}
+
+constexpr Affine3D &Affine3D::operator*=( const Affine3D &a )
+{
+    s += t * a.s;
+    t *= a.t;
+    return *this;
+}
+
+constexpr Vector3D Affine3D::operator()( const Vector3D &a ) const
+{
+    return t * a + s;
+}
+
+inline bool Affine3D::operator==( const Affine3D &a ) const
+{
+    return ( s == a.s ) && ( t == a.t );
+}
+
+inline bool Affine3D::operator!=( const Affine3D &a ) const
+{
+    return ( s != a.s ) || ( t != a.t );
+}
+
+inline Affine3D Affine3D::inv() const
+{
+    auto tInv = t.inv();
+    return Affine3D( tInv, -tInv * s );
+}
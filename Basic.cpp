@@ -3,31 +3,31 @@
 #include <shlwapi.h>
 #include <cstring>
 
-void copy( void *destination, const void *source, unsigned bytes )
+void copy( void *destination, const void *source, size_t bytes )
 {
     if( bytes > 0 )
         std::memcpy( destination, source, bytes );
 }
 
-void move( void *destination, const void *source, unsigned bytes )
+void move( void *destination, const void *source, size_t bytes )
 {
     if( bytes > 0 )
         std::memmove( destination, source, bytes );
 }
 
-void clear( void *destination, unsigned bytes )
+void clear( void *destination, size_t bytes )
 {
     if( bytes > 0 )
         std::memset( destination, 0, bytes );
 }
 
-void clear( void *destination, unsigned char sample, unsigned bytes )
+void clear( void *destination, unsigned char sample, size_t bytes )
 {
     if( bytes > 0 )
         std::memset( destination, sample, bytes );
 }
 
-void swap( void* destination, void* source, unsigned bytes )
+void swap( void* destination, void* source, size_t bytes )
 {
     if( destination == source )
         return;
@@ -36,7 +36,7 @@ void swap( void* destination, void* source, unsigned bytes )
 
     while( bytes > 0 )
     {
-        unsigned chunk = ( bytes < sizeof( buffer ) ) ? bytes : sizeof( buffer );
+        size_t chunk = ( bytes < sizeof( buffer ) ) ? bytes : sizeof( buffer );
 
         std::memcpy( buffer, destination, chunk );
         std::memcpy( destination, source, chunk );
@@ -48,7 +48,7 @@ void swap( void* destination, void* source, unsigned bytes )
     }
 }
 
-bool compare( const void *source0, const void *source1, unsigned bytes )
+bool compare( const void *source0, const void *source1, size_t bytes )
 {
     if( bytes <= 0 )
         return true;
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <type_traits>
+#include <cstddef>
 #include <limits>
 #include <cmath>
 
@@ -305,11 +306,11 @@ public:
     };
 };
 
-void copy( void *destination, const void *source, unsigned bytes );
-void move( void *destination, const void *source, unsigned bytes );
-void clear( void *destination, unsigned bytes );
-void clear( void *destination, unsigned char sample, unsigned bytes );
-void swap( void* destination, void* source, unsigned bytes );
-bool compare( const void *source0, const void *source1, unsigned bytes );
+void copy( void *destination, const void *source, size_t bytes );
+void move( void *destination, const void *source, size_t bytes );
+void clear( void *destination, size_t bytes );
+void clear( void *destination, unsigned char sample, size_t bytes );
+void swap( void* destination, void* source, size_t bytes );
+bool compare( const void *source0, const void *source1, size_t bytes );
 bool compare( const wchar_t *string0, const wchar_t *string1 );
 unsigned stringLength( const char *string );
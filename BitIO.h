@@ -41,7 +41,7 @@ public:
 
     bool read( long long unsigned bytes, void *value ) override
     {
-        if( p + bytes > end )
+        if( bytes > ( long long unsigned )( end - p ) )
             return false;
         if( value )
             copy( value, p, bytes );
@@ -70,7 +70,7 @@ public:
 
     bool write( long long unsigned bytes, const void *value ) override
     {
-        if( p + bytes > end )
+        if( bytes > ( long long unsigned )( end - p ) )
             return false;
         copy( p, value, bytes );
         p += bytes;
@@ -118,6 +118,7 @@ public:
     Reader( const void *link, long long unsigned bytes, long long unsigned offset )
     {
         makeException( bytes >= offset );
+        makeException( bytes - offset <= std::numeric_limits<long long unsigned>::max() / 8 );
 
         p = start = ( const uint8_t * )link + offset;
         bitVolume = ( bytes - offset ) * 8;
@@ -126,8 +127,9 @@ public:
 
     bool read( long long unsigned bits, BitList &value ) override
     {
-        if( ( bitPosition += bits ) > bitVolume )
+        if( bits > bitVolume - bitPosition )
             return false;
+        bitPosition += bits;
 
         readBits( p.pointer, p.bitOffset, bits, value );
         return true;
@@ -137,15 +139,16 @@ public:
     {
         makeException( p.bitOffset == 0 );
 
-        if( ( bitPosition += 8 * bytes ) > bitVolume )
+        if( bytes > ( bitVolume - bitPosition ) / 8 )
             return false;
+        bitPosition += 8 * bytes;
 
         copy( value, p.pointer, bytes );
         p.pointer += bytes;
         return true;
     }
 
-    unsigned bytesLeft( long long unsigned limit ) const
+    long long unsigned bytesLeft( long long unsigned limit ) const
     {
         makeException( p.bitOffset == 0 );
         makeException( bitPosition <= bitVolume );
@@ -170,6 +173,7 @@ public:
     Writer( void *link, long long unsigned bytes, long long unsigned offset )
     {
         makeException( bytes >= offset );
+        makeException( bytes - offset <= std::numeric_limits<long long unsigned>::max() / 8 );
 
         p = start = ( uint8_t * )link + offset;
         bitVolume = ( bytes - offset ) * 8;
@@ -178,8 +182,9 @@ public:
 
     bool write( long long unsigned bits, BitList value ) override
     {
-        if( ( bitPosition += bits ) > bitVolume )
+        if( bits > bitVolume - bitPosition )
             return false;
+        bitPosition += bits;
 
         writeBits( p.pointer, p.bitOffset, bits, value );
         return true;
@@ -189,8 +194,9 @@ public:
     {
         makeException( p.bitOffset == 0 );
 
-        if( ( bitPosition += 8 * bytes ) > bitVolume )
+        if( bytes > ( bitVolume - bitPosition ) / 8 )
             return false;
+        bitPosition += 8 * bytes;
 
         copy( p.pointer, value, bytes );
         p.pointer += bytes;
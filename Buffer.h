@@ -1,12 +1,13 @@
 #pragma once
 
+#include "Exception.h"
 #include "Basic.h"
 
 class BufferBase
 {
 protected:
     void *pointer, *data;
-    unsigned dataLength, bufferLength;
+    size_t dataLength, bufferLength;
 public:
     BufferBase()
     {
@@ -19,12 +20,12 @@ public:
     virtual ~BufferBase()
     {}
 
-    unsigned length() const
+    size_t length() const
     {
         return dataLength;
     }
 
-    unsigned store() const
+    size_t store() const
     {
         return bufferLength;
     }
@@ -43,7 +44,7 @@ public:
     Buffer() : Parent()
     {}
 
-    Buffer( unsigned n ) : Parent()
+    Buffer( size_t n ) : Parent()
     {
         reset( n );
     }
@@ -63,27 +64,28 @@ public:
         delete[]( T * )data;
     }
 
-    T *operator[]( unsigned i )
+    T *operator[]( size_t i )
     {
         if( ( i + 1 ) * sizeof( T ) <= dataLength )
             return ( T * )pointer + i;
         return nullptr;
     }
 
-    const T *operator[]( unsigned i ) const
+    const T *operator[]( size_t i ) const
     {
         if( ( i + 1 ) * sizeof( T ) <= dataLength )
             return ( const T * )pointer + i;
         return nullptr;
     }
 
-    unsigned count() const
+    size_t count() const
     {
         return dataLength / sizeof( T ) + ( dataLength % sizeof( T ) > 0 );
     }
 
-    void reset( unsigned n )
+    void reset( size_t n )
     {
+        makeException( n <= std::numeric_limits<size_t>::max() / sizeof( T ) );
         Self::dataLength = Self::bufferLength = n * sizeof( T );
 
         delete[]( T * )Self::data;
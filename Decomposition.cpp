@@ -0,0 +1 @@
+#include "Decomposition.h"
@@ -0,0 +1,355 @@
+#pragma once
+
+#include <type_traits>
+#include <utility>
+#include <limits>
+#include <vector>
+#include <cmath>
+
+#include "Exception.h"
+#include "Multiply.h"
+#include "Parallel.h"
+#include "Matrix.h"
+#include "Basic.h"
+
+// Number of columns of LU decomposition, that are factorized together, before the rest of matrix is updated by multiplication
+#define DECOMPOSITION_BLOCK 64
+
+// Work, measured in multiplications, that one thread gets at least, when reflections are applied
+#define DECOMPOSITION_GRANULE 65536
+
+// LU decomposition with partial pivoting: rows of matrix, exchanged in order of 'pivots', are equal to L * U
+// L has units on diagonal, both L and U are stored in 'lu'
+template<typename T>
+class LUDecomposition
+{
+    static_assert( std::is_floating_point_v<T> );
+
+private:
+    MatrixBase<T> lu;
+    std::vector<int> pivots;
+    int sign;
+    bool degenerate;
+
+    // Factorizes columns [first, last) below 'first' line, exchanges whole lines
+    void panel( int first, int last )
+    {
+        int n = lu.w();
+        for( int k = first; k < last; ++k )
+        {
+            int pivot = k;
+            for( int i = k + 1; i < n; ++i )
+            {
+                if( std::abs( *lu( k, i ) ) > std::abs( *lu( k, pivot ) ) )
+                    pivot = i;
+            }
+
+            pivots[k] = pivot;
+            if( pivot != k )
+            {
+                T *a = lu( 0, k ), *b = lu( 0, pivot );
+                for( int j = 0; j < n; ++j )
+                    std::swap( a[j], b[j] );
+                sign = -sign;
+            }
+
+            const T *top = lu( 0, k );
+            if( top[k] == T() )
+            {
+                degenerate = true;
+                continue;
+            }
+
+            for( int i = k + 1; i < n; ++i )
+            {
+                T *line = lu( 0, i );
+                T factor = line[k] /= top[k];
+                for( int j = k + 1; j < last; ++j )
+                    line[j] -= factor * top[j];
+            }
+        }
+    }
+public:
+    explicit LUDecomposition( const MatrixBase<T> &matrix ) : lu( matrix ), sign( 1 ), degenerate( false )
+    {
+        // Decomposition is only defined for square matrices
+        makeException( matrix.w() == matrix.h() );
+
+        int n = lu.w();
+        pivots.resize( n );
+
+        for( int first = 0; first < n; first += DECOMPOSITION_BLOCK )
+        {
+            int last = Min( first + DECOMPOSITION_BLOCK, n ), rest = n - last;
+            panel( first, last );
+            if( rest <= 0 )
+                break;
+
+            // Lines of U to the right of block: forward substitution with L of block
+            for( int i = first + 1; i < last; ++i )
+            {
+                T *line = lu( 0, i );
+                for( int k = first; k < i; ++k )
+                {
+                    const T *upper = lu( 0, k );
+                    for( int j = last; j < n; ++j )
+                        line[j] -= line[k] * upper[j];
+                }
+            }
+
+            // Rest of matrix loses product of L below block and U to the right of it
+            MatrixBase<T> lower( last - first, rest ), upper( rest, last - first ), product;
+            for( int i = 0; i < rest; ++i )
+                ::copy( lower( 0, i ), lu( first, last + i ), ( last - first ) * sizeof( T ) );
+            for( int i = 0; i < last - first; ++i )
+                ::copy( upper( 0, i ), lu( last, first + i ), rest * sizeof( T ) );
+            multiply( lower, upper, product );
+
+            parallelFor( rest, [&]( size_t begin, size_t end )
+            {
+                for( int i = begin; i < int( end ); ++i )
+                {
+                    T *line = lu( last, last + i );
+                    const T *subtrahend = product( 0, i );
+                    for( int j = 0; j < rest; ++j )
+                        line[j] -= subtrahend[j];
+                }
+            }, DECOMPOSITION_BLOCK );
+        }
+    }
+
+    int size() const
+    {
+        return lu.w();
+    }
+
+    // True, if some pivot is zero
+    bool singular() const
+    {
+        return degenerate;
+    }
+
+    T det() const
+    {
+        T result = T( sign );
+        for( int i = 0; i < size(); ++i )
+            result *= *lu( i, i );
+        return result;
+    }
+
+    // Solves matrix * x = b for every column of 'b', which has as many lines, as matrix
+    void solve( const MatrixBase<T> &b, MatrixBase<T> &x ) const
+    {
+        // Matrix is singular, system doesn't have a unique solution
+        makeException( !degenerate );
+
+        // Right sides must have as many lines, as matrix
+        makeException( b.h() == size() );
+
+        MatrixBase<T> result( b );
+        int n = size(), m = result.w();
+        for( int k = 0; k < n; ++k )
+        {
+            if( pivots[k] != k )
+            {
+                T *first = result( 0, k ), *second = result( 0, pivots[k] );
+                for( int j = 0; j < m; ++j )
+                    std::swap( first[j], second[j] );
+            }
+        }
+
+        // Columns of right sides are independent, so threads take different columns
+        parallelFor( m, [&]( size_t begin, size_t end )
+        {
+            for( int i = 0; i < n; ++i )
+            {
+                T *line = result( 0, i );
+                const T *factors = lu( 0, i );
+                for( int k = 0; k < i; ++k )
+                {
+                    const T *known = result( 0, k );
+                    for( size_t j = begin; j < end; ++j )
+                        line[j] -= factors[k] * known[j];
+                }
+            }
+
+            for( int i = n - 1; i >= 0; --i )
+            {
+                T *line = result( 0, i );
+                const T *factors = lu( 0, i );
+                for( int k = i + 1; k < n; ++k )
+                {
+                    const T *known = result( 0, k );
+                    for( size_t j = begin; j < end; ++j )
+                        line[j] -= factors[k] * known[j];
+                }
+                for( size_t j = begin; j < end; ++j )
+                    line[j] /= factors[i];
+            }
+        }, 16 );
+
+        x = std::move( result );
+    }
+
+    void inverse( MatrixBase<T> &result ) const
+    {
+        MatrixBase<T> identity( size(), size() );
+        for( int i = 0; i < size(); ++i )
+        {
+            T *line = identity( 0, i );
+            for( int j = 0; j < size(); ++j )
+                line[j] = i == j ? T( 1 ) : T();
+        }
+        solve( identity, result );
+    }
+};
+
+// Householder QR decomposition with column pivoting: matrix with exchanged columns is equal to Q * R
+// Vectors of reflections are stored below diagonal of 'qr', R is stored above it
+template<typename T>
+class QRDecomposition
+{
+    static_assert( std::is_floating_point_v<T> );
+
+private:
+    MatrixBase<T> qr;
+    std::vector<T> taus;
+    std::vector<int> columns;
+    int independent;
+
+    // Applies reflection 'k' to columns [first, last) of 'target', which has as many lines, as matrix
+    void reflect( int k, MatrixBase<T> &target, int first, int last ) const
+    {
+        int m = qr.h();
+        T tau = taus[k];
+        if( tau == T() || first >= last )
+            return;
+
+        // w = v^T * target, target -= tau * v * w, where v[k] = 1, lines are traversed, so values are contiguous
+        size_t granule = Max( DECOMPOSITION_GRANULE / ( m - k ), 1 );
+        parallelFor( last - first, [&]( size_t begin, size_t end )
+        {
+            std::vector<T> w( target( first + begin, k ), target( first + begin, k ) + ( end - begin ) );
+            for( int i = k + 1; i < m; ++i )
+            {
+                T v = *qr( k, i );
+                const T *line = target( first + begin, i );
+                for( size_t j = 0; j < end - begin; ++j )
+                    w[j] += v * line[j];
+            }
+
+            for( int i = k; i < m; ++i )
+            {
+                T v = i == k ? T( 1 ) : *qr( k, i );
+                T *line = target( first + begin, i );
+                for( size_t j = 0; j < end - begin; ++j )
+                    line[j] -= tau * v * w[j];
+            }
+        }, granule );
+    }
+public:
+    explicit QRDecomposition( const MatrixBase<T> &matrix ) : qr( matrix ), independent( 0 )
+    {
+        int m = qr.h(), n = qr.w(), steps = Min( m, n );
+        taus.assign( steps, T() );
+        columns.resize( n );
+        for( int j = 0; j < n; ++j )
+            columns[j] = j;
+
+        std::vector<T> norms( n );
+        for( int k = 0; k < steps; ++k )
+        {
+            // Column with the largest remaining norm goes next, so R has decreasing diagonal
+            for( int j = k; j < n; ++j )
+                norms[j] = T();
+            for( int i = k; i < m; ++i )
+            {
+                const T *line = qr( 0, i );
+                for( int j = k; j < n; ++j )
+                    norms[j] += line[j] * line[j];
+            }
+
+            int pivot = k;
+            for( int j = k + 1; j < n; ++j )
+            {
+                if( norms[j] > norms[pivot] )
+                    pivot = j;
+            }
+
+            if( pivot != k )
+            {
+                std::swap( columns[k], columns[pivot] );
+                for( int i = 0; i < m; ++i )
+                {
+                    T *line = qr( 0, i );
+                    std::swap( line[k], line[pivot] );
+                }
+            }
+
+            T norm = std::sqrt( norms[pivot] ), alpha = *qr( k, k );
+            if( norm == T() )
+                continue;
+
+            T beta = alpha > T() ? -norm : norm;
+            T scale = T( 1 ) / ( alpha - beta );
+            for( int i = k + 1; i < m; ++i )
+                *qr( k, i ) *= scale;
+            taus[k] = ( beta - alpha ) / beta;
+            *qr( k, k ) = beta;
+
+            reflect( k, qr, k + 1, n );
+        }
+
+        // Diagonal values below tolerance are treated as zero
+        T tolerance = steps > 0 ? std::abs( *qr( 0, 0 ) ) * Max( m, n ) * std::numeric_limits<T>::epsilon() : T();
+        while( independent < steps && std::abs( *qr( independent, independent ) ) > tolerance )
+            ++independent;
+    }
+
+    // Number of linearly independent columns
+    int rank() const
+    {
+        return independent;
+    }
+
+    // Finds x with the least norm of matrix * x - b for every column of 'b', which has as many lines, as matrix
+    // Columns, that depend on others, get zero values
+    void solve( const MatrixBase<T> &b, MatrixBase<T> &x ) const
+    {
+        // Right sides must have as many lines, as matrix
+        makeException( b.h() == qr.h() );
+
+        MatrixBase<T> y( b );
+        for( int k = 0; k < int( taus.size() ); ++k )
+            reflect( k, y, 0, y.w() );
+
+        int n = qr.w(), m = y.w();
+        MatrixBase<T> result( m, n );
+        for( int i = 0; i < n; ++i )
+        {
+            T *line = result( 0, i );
+            for( int j = 0; j < m; ++j )
+                line[j] = T();
+        }
+
+        // Back substitution over independent columns, R is read in exchanged order
+        for( int i = independent - 1; i >= 0; --i )
+        {
+            T *line = y( 0, i );
+            const T *factors = qr( 0, i );
+            for( int k = i + 1; k < independent; ++k )
+            {
+                const T *known = y( 0, k );
+                for( int j = 0; j < m; ++j )
+                    line[j] -= factors[k] * known[j];
+            }
+            for( int j = 0; j < m; ++j )
+                line[j] /= factors[i];
+        }
+
+        for( int i = 0; i < independent; ++i )
+            ::copy( result( 0, columns[i] ), y( 0, i ), m * sizeof( T ) );
+
+        x = std::move( result );
+    }
+};
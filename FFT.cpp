@@ -0,0 +1,446 @@
+#include "FFT.h"
+
+#include <cmath>
+
+#include "Parallel.h"
+#include "Basic.h"
+
+static const double PI = 3.14159265358979323846;
+
+size_t fourierSize( size_t n )
+{
+    size_t size = 1;
+    while( size < n )
+        size <<= 1;
+    return size;
+}
+
+bool fourierConvolutionFaster( int sourceWidth, int sourceHeight, int kernelWidth, int kernelHeight )
+{
+    double kernelArea = double( kernelWidth ) * kernelHeight;
+    if( kernelArea < FFT_CONVOLUTION_AREA )
+        return false;
+
+    double direct = double( sourceWidth - kernelWidth + 1 ) * ( sourceHeight - kernelHeight + 1 ) * kernelArea;
+    double area = double( fourierSize( sourceWidth ) ) * fourierSize( sourceHeight );
+    return direct > FFT_CONVOLUTION_COST * area * std::log2( area );
+}
+
+FourierPlan::FourierPlan( size_t size ) : n( size ), radix2( false )
+{
+    makeException( n > 0 );
+
+    if( n & ( n - 1 ) )
+    {
+        // Chirp angle uses k^2 modulo 2n, so it stays accurate for large k
+        chirpRe.resize( n );
+        chirpIm.resize( n );
+        for( size_t k = 0; k < n; ++k )
+        {
+            double angle = PI * double( k * k % ( 2 * n ) ) / n;
+            chirpRe[k] = std::cos( angle );
+            chirpIm[k] = -std::sin( angle );
+        }
+
+        // Linear convolution with chirp of length 2n - 1 must not wrap
+        inner = std::make_shared<const FourierPlan>( fourierSize( 2 * n - 1 ) );
+        size_t m = inner->size();
+        filterRe.assign( m, 0 );
+        filterIm.assign( m, 0 );
+        for( size_t k = 0; k < n; ++k )
+        {
+            filterRe[k] = chirpRe[k];
+            filterIm[k] = -chirpIm[k];
+            if( k > 0 )
+            {
+                filterRe[m - k] = chirpRe[k];
+                filterIm[m - k] = -chirpIm[k];
+            }
+        }
+        inner->forward( filterRe.data(), filterIm.data() );
+        return;
+    }
+
+    unsigned bits = 0;
+    while( ( size_t( 1 ) << bits ) < n )
+        ++bits;
+
+    reversal.resize( n );
+    for( size_t i = 0; i < n; ++i )
+    {
+        size_t r = 0;
+        for( unsigned b = 0; b < bits; ++b )
+            r |= ( ( i >> b ) & 1 ) << ( bits - 1 - b );
+        reversal[i] = r;
+    }
+
+    radix2 = bits % 2 == 1;
+    for( size_t m = radix2 ? 2 : 1; 4 * m <= n; m *= 4 )
+    {
+        Stage stage;
+        stage.m = m;
+        stage.re1.resize( m );
+        stage.im1.resize( m );
+        stage.re2.resize( m );
+        stage.im2.resize( m );
+        stage.re3.resize( m );
+        stage.im3.resize( m );
+        for( size_t k = 0; k < m; ++k )
+        {
+            double angle = -2 * PI * double( k ) / double( 4 * m );
+            stage.re1[k] = std::cos( angle );
+            stage.im1[k] = std::sin( angle );
+            stage.re2[k] = std::cos( 2 * angle );
+            stage.im2[k] = std::sin( 2 * angle );
+            stage.re3[k] = std::cos( 3 * angle );
+            stage.im3[k] = std::sin( 3 * angle );
+        }
+        stages.push_back( std::move( stage ) );
+    }
+}
+
+size_t FourierPlan::size() const
+{
+    return n;
+}
+
+void FourierPlan::radix( double *re, double *im ) const
+{
+    for( size_t i = 0; i < n; ++i )
+    {
+        size_t r = reversal[i];
+        if( i < r )
+        {
+            std::swap( re[i], re[r] );
+            std::swap( im[i], im[r] );
+        }
+    }
+
+    if( radix2 )
+    {
+        for( size_t i = 0; i < n; i += 2 )
+        {
+            double r = re[i + 1], s = im[i + 1];
+            re[i + 1] = re[i] - r;
+            im[i + 1] = im[i] - s;
+            re[i] += r;
+            im[i] += s;
+        }
+    }
+
+    for( auto &stage : stages )
+    {
+        size_t m = stage.m;
+        for( size_t block = 0; block < n; block += 4 * m )
+        {
+            double *r0 = re + block, *r1 = r0 + m, *r2 = r1 + m, *r3 = r2 + m;
+            double *i0 = im + block, *i1 = i0 + m, *i2 = i1 + m, *i3 = i2 + m;
+
+            // Quarters hold transforms A, B, C, D of size m, their twiddled values are t1 = w^2k B, t2 = w^k C, t3 = w^3k D
+            for( size_t k = 0; k < m; ++k )
+            {
+                double ar = r0[k], ai = i0[k];
+                double t1r = r1[k] * stage.re2[k] - i1[k] * stage.im2[k];
+                double t1i = r1[k] * stage.im2[k] + i1[k] * stage.re2[k];
+                double t2r = r2[k] * stage.re1[k] - i2[k] * stage.im1[k];
+                double t2i = r2[k] * stage.im1[k] + i2[k] * stage.re1[k];
+                double t3r = r3[k] * stage.re3[k] - i3[k] * stage.im3[k];
+                double t3i = r3[k] * stage.im3[k] + i3[k] * stage.re3[k];
+
+                double sr = ar + t1r, si = ai + t1i, dr = ar - t1r, di = ai - t1i;
+                double pr = t2r + t3r, pi = t2i + t3i, qr = t2r - t3r, qi = t2i - t3i;
+
+                // Multiplication by -i turns (qr, qi) into (qi, -qr)
+                r0[k] = sr + pr;
+                i0[k] = si + pi;
+                r2[k] = sr - pr;
+                i2[k] = si - pi;
+                r1[k] = dr + qi;
+                i1[k] = di - qr;
+                r3[k] = dr - qi;
+                i3[k] = di + qr;
+            }
+        }
+    }
+}
+
+void FourierPlan::bluestein( double *re, double *im ) const
+{
+    size_t m = inner->size();
+    std::vector<double> ar( m, 0 ), ai( m, 0 );
+    for( size_t k = 0; k < n; ++k )
+    {
+        ar[k] = re[k] * chirpRe[k] - im[k] * chirpIm[k];
+        ai[k] = re[k] * chirpIm[k] + im[k] * chirpRe[k];
+    }
+
+    inner->forward( ar.data(), ai.data() );
+    for( size_t k = 0; k < m; ++k )
+    {
+        double r = ar[k] * filterRe[k] - ai[k] * filterIm[k];
+        ai[k] = ar[k] * filterIm[k] + ai[k] * filterRe[k];
+        ar[k] = r;
+    }
+    inner->inverse( ar.data(), ai.data() );
+
+    for( size_t k = 0; k < n; ++k )
+    {
+        re[k] = ar[k] * chirpRe[k] - ai[k] * chirpIm[k];
+        im[k] = ar[k] * chirpIm[k] + ai[k] * chirpRe[k];
+    }
+}
+
+void FourierPlan::forward( double *re, double *im ) const
+{
+    if( inner )
+        bluestein( re, im );
+    else
+        radix( re, im );
+}
+
+void FourierPlan::inverse( double *re, double *im ) const
+{
+    // Swapping real and imaginary parts conjugates values and multiplies them by i, which turns forward transform into inverse one
+    forward( im, re );
+
+    double scale = 1.0 / n;
+    for( size_t k = 0; k < n; ++k )
+    {
+        re[k] *= scale;
+        im[k] *= scale;
+    }
+}
+
+void FourierPlan::forward( std::vector<Complex> &data ) const
+{
+    makeException( data.size() == n );
+
+    std::vector<double> re( n ), im( n );
+    for( size_t k = 0; k < n; ++k )
+    {
+        re[k] = data[k].a;
+        im[k] = data[k].b;
+    }
+    forward( re.data(), im.data() );
+    for( size_t k = 0; k < n; ++k )
+        data[k] = Complex( re[k], im[k] );
+}
+
+void FourierPlan::inverse( std::vector<Complex> &data ) const
+{
+    makeException( data.size() == n );
+
+    std::vector<double> re( n ), im( n );
+    for( size_t k = 0; k < n; ++k )
+    {
+        re[k] = data[k].a;
+        im[k] = data[k].b;
+    }
+    inverse( re.data(), im.data() );
+    for( size_t k = 0; k < n; ++k )
+        data[k] = Complex( re[k], im[k] );
+}
+
+RealFourierPlan::RealFourierPlan( size_t size ) : n( size ), half( size % 2 == 0 ? size / 2 : size )
+{
+    if( n % 2 )
+        return;
+
+    twiddleRe.resize( n / 2 );
+    twiddleIm.resize( n / 2 );
+    for( size_t k = 0; k < n / 2; ++k )
+    {
+        double angle = -2 * PI * double( k ) / double( n );
+        twiddleRe[k] = std::cos( angle );
+        twiddleIm[k] = std::sin( angle );
+    }
+}
+
+size_t RealFourierPlan::size() const
+{
+    return n;
+}
+
+size_t RealFourierPlan::spectrumSize() const
+{
+    return n / 2 + 1;
+}
+
+void RealFourierPlan::forward( const double *input, double *re, double *im ) const
+{
+    if( n % 2 )
+    {
+        std::vector<double> zr( input, input + n ), zi( n, 0 );
+        half.forward( zr.data(), zi.data() );
+        copy( re, zr.data(), spectrumSize() * sizeof( double ) );
+        copy( im, zi.data(), spectrumSize() * sizeof( double ) );
+        return;
+    }
+
+    // Even values are real parts, odd values are imaginary parts
+    size_t h = n / 2;
+    std::vector<double> zr( h ), zi( h );
+    for( size_t j = 0; j < h; ++j )
+    {
+        zr[j] = input[2 * j];
+        zi[j] = input[2 * j + 1];
+    }
+    half.forward( zr.data(), zi.data() );
+
+    // Transforms of even values E = ( Z[k] + Z*[h - k] ) / 2 and odd values O = ( Z[k] - Z*[h - k] ) / 2i
+    for( size_t k = 0; k < h; ++k )
+    {
+        size_t c = k ? h - k : 0;
+        double er = 0.5 * ( zr[k] + zr[c] ), ei = 0.5 * ( zi[k] - zi[c] );
+        double or_ = 0.5 * ( zi[k] + zi[c] ), oi = -0.5 * ( zr[k] - zr[c] );
+        re[k] = er + or_ * twiddleRe[k] - oi * twiddleIm[k];
+        im[k] = ei + or_ * twiddleIm[k] + oi * twiddleRe[k];
+    }
+    re[h] = zr[0] - zi[0];
+    im[h] = 0;
+}
+
+void RealFourierPlan::inverse( const double *re, const double *im, double *output ) const
+{
+    if( n % 2 )
+    {
+        // Other half of spectrum consists of conjugates
+        std::vector<double> zr( n ), zi( n );
+        for( size_t k = 0; k < n; ++k )
+        {
+            size_t c = k < spectrumSize() ? k : n - k;
+            zr[k] = re[c];
+            zi[k] = k < spectrumSize() ? im[c] : -im[c];
+        }
+        half.inverse( zr.data(), zi.data() );
+        copy( output, zr.data(), n * sizeof( double ) );
+        return;
+    }
+
+    // Z[k] = E + iO, where E = ( X[k] + X*[h - k] ) / 2 and O = ( X[k] - X*[h - k] ) / 2 * exp( 2 pi i k / n )
+    size_t h = n / 2;
+    std::vector<double> zr( h ), zi( h );
+    for( size_t k = 0; k < h; ++k )
+    {
+        double er = 0.5 * ( re[k] + re[h - k] ), ei = 0.5 * ( im[k] - im[h - k] );
+        double dr = 0.5 * ( re[k] - re[h - k] ), di = 0.5 * ( im[k] + im[h - k] );
+        double or_ = dr * twiddleRe[k] + di * twiddleIm[k];
+        double oi = di * twiddleRe[k] - dr * twiddleIm[k];
+        zr[k] = er - oi;
+        zi[k] = ei + or_;
+    }
+    half.inverse( zr.data(), zi.data() );
+
+    for( size_t j = 0; j < h; ++j )
+    {
+        output[2 * j] = zr[j];
+        output[2 * j + 1] = zi[j];
+    }
+}
+
+RealFourierPlan2D::RealFourierPlan2D( size_t width, size_t height ) : rows( width ), columns( height )
+{}
+
+size_t RealFourierPlan2D::width() const
+{
+    return rows.size();
+}
+
+size_t RealFourierPlan2D::height() const
+{
+    return columns.size();
+}
+
+size_t RealFourierPlan2D::spectrumWidth() const
+{
+    return rows.spectrumSize();
+}
+
+// Transforms columns of split matrix, every thread gathers its columns into contiguous arrays
+static void transformColumns( const FourierPlan &plan, double *re, double *im, size_t width, bool inverse )
+{
+    size_t height = plan.size();
+    parallelFor( width, [&]( size_t begin, size_t end )
+    {
+        std::vector<double> cr( height ), ci( height );
+        for( size_t j = begin; j < end; ++j )
+        {
+            for( size_t i = 0; i < height; ++i )
+            {
+                cr[i] = re[i * width + j];
+                ci[i] = im[i * width + j];
+            }
+
+            if( inverse )
+                plan.inverse( cr.data(), ci.data() );
+            else
+                plan.forward( cr.data(), ci.data() );
+
+            for( size_t i = 0; i < height; ++i )
+            {
+                re[i * width + j] = cr[i];
+                im[i * width + j] = ci[i];
+            }
+        }
+    }, 4 );
+}
+
+void RealFourierPlan2D::forward( const double *input, double *re, double *im ) const
+{
+    size_t w = width(), sw = spectrumWidth();
+    parallelFor( height(), [&]( size_t begin, size_t end )
+    {
+        for( size_t i = begin; i < end; ++i )
+            rows.forward( input + i * w, re + i * sw, im + i * sw );
+    }, 4 );
+    transformColumns( columns, re, im, sw, false );
+}
+
+void RealFourierPlan2D::inverse( double *re, double *im, double *output ) const
+{
+    size_t w = width(), sw = spectrumWidth();
+    transformColumns( columns, re, im, sw, true );
+    parallelFor( height(), [&]( size_t begin, size_t end )
+    {
+        for( size_t i = begin; i < end; ++i )
+            rows.inverse( re + i * sw, im + i * sw, output + i * w );
+    }, 4 );
+}
+
+void fourier( MatrixBase<Complex> &data, bool inverse )
+{
+    if( data.empty() )
+        return;
+
+    size_t w = data.w(), h = data.h();
+    std::vector<double> re( w * h ), im( w * h );
+    for( size_t i = 0; i < h; ++i )
+    {
+        auto line = data( 0, i );
+        for( size_t j = 0; j < w; ++j )
+        {
+            re[i * w + j] = line[j].a;
+            im[i * w + j] = line[j].b;
+        }
+    }
+
+    FourierPlan lines( w ), columns( h );
+    parallelFor( h, [&]( size_t begin, size_t end )
+    {
+        for( size_t i = begin; i < end; ++i )
+        {
+            if( inverse )
+                lines.inverse( re.data() + i * w, im.data() + i * w );
+            else
+                lines.forward( re.data() + i * w, im.data() + i * w );
+        }
+    }, 4 );
+    transformColumns( columns, re.data(), im.data(), w, inverse );
+
+    for( size_t i = 0; i < h; ++i )
+    {
+        auto line = data( 0, i );
+        for( size_t j = 0; j < w; ++j )
+            line[j] = Complex( re[i * w + j], im[i * w + j] );
+    }
+}
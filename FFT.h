@@ -0,0 +1,161 @@
+#pragma once
+
+#include <type_traits>
+#include <vector>
+#include <memory>
+
+#include "Exception.h"
+#include "Complex.h"
+#include "Matrix.h"
+
+// Discrete Fourier transform X[k] = sum( x[j] * exp( -2 pi i j k / n ) ), inverse transforms divide by n
+// Values are kept in split arrays of real and imaginary parts, so every butterfly works on contiguous values
+// Plans hold tables for a fixed size and are constant after construction, so they can be shared between threads
+
+// Kernels with area starting from this, that aren't separable, may be applied through spectra
+#define FFT_CONVOLUTION_AREA 256
+
+// Estimated cost of convolution through spectra per value of padded matrix and per bit of its area
+// Measured in multiplications of direct convolution
+#define FFT_CONVOLUTION_COST 16
+
+// Smallest power of two, that isn't less than 'n'
+size_t fourierSize( size_t n );
+
+class FourierPlan
+{
+private:
+    // Radix-4 pass, that combines 4 transforms of size 'm' with twiddles w^k, w^2k, w^3k, w = exp( -2 pi i / 4m )
+    struct Stage
+    {
+        size_t m;
+        std::vector<double> re1, im1, re2, im2, re3, im3;
+    };
+
+    size_t n;
+
+    // Power of two sizes: bit reversal, optional radix-2 pass and radix-4 passes
+    std::vector<size_t> reversal;
+    bool radix2;
+    std::vector<Stage> stages;
+
+    // Other sizes use Bluestein's algorithm: chirp exp( -pi i k^2 / n ) and transform of its conjugate
+    std::shared_ptr<const FourierPlan> inner;
+    std::vector<double> chirpRe, chirpIm, filterRe, filterIm;
+
+    void radix( double *re, double *im ) const;
+    void bluestein( double *re, double *im ) const;
+public:
+    explicit FourierPlan( size_t size );
+
+    size_t size() const;
+
+    void forward( double *re, double *im ) const;
+    void inverse( double *re, double *im ) const;
+
+    void forward( std::vector<Complex> &data ) const;
+    void inverse( std::vector<Complex> &data ) const;
+};
+
+// Transform of real values, spectrum has size / 2 + 1 values, others are conjugates of them
+// Even sizes are transformed as complex values of half size
+class RealFourierPlan
+{
+private:
+    size_t n;
+    FourierPlan half;
+
+    // exp( -2 pi i k / n ) for k < n / 2
+    std::vector<double> twiddleRe, twiddleIm;
+public:
+    explicit RealFourierPlan( size_t size );
+
+    size_t size() const;
+    size_t spectrumSize() const;
+
+    void forward( const double *input, double *re, double *im ) const;
+    void inverse( const double *re, const double *im, double *output ) const;
+};
+
+// Transform of real matrices, stored line by line, spectrum has height lines of width / 2 + 1 values
+// Lines and columns are transformed on several threads
+class RealFourierPlan2D
+{
+private:
+    RealFourierPlan rows;
+    FourierPlan columns;
+public:
+    RealFourierPlan2D( size_t width, size_t height );
+
+    size_t width() const;
+    size_t height() const;
+    size_t spectrumWidth() const;
+
+    void forward( const double *input, double *re, double *im ) const;
+
+    // Spectrum is overwritten
+    void inverse( double *re, double *im, double *output ) const;
+};
+
+// Checks, if convolution of 'source' with 'kernel' through spectra needs less operations, than direct one
+bool fourierConvolutionFaster( int sourceWidth, int sourceHeight, int kernelWidth, int kernelHeight );
+
+// Transforms lines, then columns of complex matrix
+void fourier( MatrixBase<Complex> &data, bool inverse );
+
+// Convolution without border, same as validConvolution, computed through spectra of sizes, that are powers of two
+// Used for large kernels, that aren't separable, cost doesn't depend on size of kernel
+template<typename T>
+void fourierConvolution( const MatrixBase<T> &source, const MatrixBase<T> &kernel, MatrixBase<T> &result )
+{
+    static_assert( std::is_floating_point_v<T> );
+
+    // Kernel size must not exceed matrix size
+    makeException( kernel.w() <= source.w() && kernel.h() <= source.h() );
+
+    // Result is built separately, so it may be the same matrix, as source or kernel
+    MatrixBase<T> temporary( source.w() - kernel.w() + 1, source.h() - kernel.h() + 1 );
+    if( temporary.empty() || kernel.empty() )
+    {
+        result = std::move( temporary );
+        return;
+    }
+
+    // Circular correlation doesn't wrap for results without border, so sizes of source are enough
+    RealFourierPlan2D plan( fourierSize( source.w() ), fourierSize( source.h() ) );
+    size_t w = plan.width(), h = plan.height(), sw = plan.spectrumWidth();
+
+    auto load = [&]( const MatrixBase<T> &matrix, std::vector<double> &values )
+    {
+        values.assign( w * h, 0 );
+        for( int i = 0; i < matrix.h(); ++i )
+        {
+            auto line = matrix( 0, i );
+            for( int j = 0; j < matrix.w(); ++j )
+                values[i * w + j] = line[j];
+        }
+    };
+
+    std::vector<double> values, re( sw * h ), im( sw * h ), kernelRe( sw * h ), kernelIm( sw * h );
+    load( kernel, values );
+    plan.forward( values.data(), kernelRe.data(), kernelIm.data() );
+    load( source, values );
+    plan.forward( values.data(), re.data(), im.data() );
+
+    // Correlation multiplies by conjugate of kernel's spectrum
+    for( size_t i = 0; i < sw * h; ++i )
+    {
+        double a = re[i], b = im[i];
+        re[i] = a * kernelRe[i] + b * kernelIm[i];
+        im[i] = b * kernelRe[i] - a * kernelIm[i];
+    }
+    plan.inverse( re.data(), im.data(), values.data() );
+
+    for( int i = 0; i < temporary.h(); ++i )
+    {
+        auto line = temporary( 0, i );
+        for( int j = 0; j < temporary.w(); ++j )
+            line[j] = T( values[i * w + j] );
+    }
+    result = std::move( temporary );
+}
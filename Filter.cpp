@@ -0,0 +1,50 @@
+#include "Filter.h"
+
+#include <cmath>
+
+int borderIndex( int i, int size, Border border )
+{
+    if( 0 <= i && i < size )
+        return i;
+
+    switch( border )
+    {
+    case Border::Clamp:
+        return i < 0 ? 0 : size - 1;
+    case Border::Mirror:
+    {
+        if( size <= 1 )
+            return 0;
+
+        // Reflections repeat with this period, so kernels larger than line are handled too
+        int period = 2 * ( size - 1 );
+        i = Abs( i ) % period;
+        return i < size ? i : period - i;
+    }
+    case Border::Zero:
+        return -1;
+    }
+
+    makeException( false );
+    return -1;
+}
+
+std::vector<double> gaussianWeights( double sigma, int radius )
+{
+    makeException( sigma > 0 && radius >= 0 );
+
+    if( radius <= 0 )
+        radius = int( std::ceil( 3 * sigma ) );
+
+    std::vector<double> weights( 2 * radius + 1 );
+    double sum = 0;
+    for( int k = -radius; k <= radius; ++k )
+    {
+        weights[k + radius] = std::exp( -0.5 * k * k / ( sigma * sigma ) );
+        sum += weights[k + radius];
+    }
+
+    for( auto &weight : weights )
+        weight /= sum;
+    return weights;
+}
@@ -0,0 +1,510 @@
+#pragma once
+
+#include <type_traits>
+#include <limits>
+#include <vector>
+
+#include "Exception.h"
+#include "Parallel.h"
+#include "Matrix.h"
+#include "Basic.h"
+#include "FFT.h"
+
+// Kernels of length starting from this, that have equal weights, are computed with running sums
+#define FILTER_RUNNING_SUM 8
+
+// Number of values of result, that are kept in registers, while taps are added
+#define FILTER_LANES 16
+
+// Values, that filters read outside of an image
+enum class Border
+{
+    // Nearest value of the image
+    Clamp,
+    // Reflection about the edge value, which isn't repeated: 2 1 | 0 1 2 | 1 0
+    Mirror,
+    // Zero
+    Zero
+};
+
+// Returns index of the value, that is read for position 'i' of line of 'size' values, -1 for zero
+int borderIndex( int i, int size, Border border );
+
+// Weights of normalized gaussian with 2 * radius + 1 taps, radius of 0 is chosen to cover 3 sigmas
+std::vector<double> gaussianWeights( double sigma, int radius = 0 );
+
+// Kernel, that is a product of column and row: kernel( j, i ) = column[i] * row[j]
+// As for matrix kernels, anchor is at row.size() / 2, column.size() / 2
+template<typename T>
+struct SeparableKernel
+{
+    std::vector<T> row, column;
+};
+
+template<typename T>
+SeparableKernel<T> gaussianKernel( double sigmaX, double sigmaY )
+{
+    SeparableKernel<T> kernel;
+    for( auto weight : gaussianWeights( sigmaX ) )
+        kernel.row.push_back( T( weight ) );
+    for( auto weight : gaussianWeights( sigmaY ) )
+        kernel.column.push_back( T( weight ) );
+    return kernel;
+}
+
+// Weights of floating kernels are normalized, integer kernels have weights of 1 and compute sums
+template<typename T>
+SeparableKernel<T> boxKernel( int width, int height )
+{
+    makeException( width > 0 && height > 0 );
+
+    SeparableKernel<T> kernel;
+    if constexpr( std::is_floating_point_v<T> )
+    {
+        kernel.row.assign( width, T( 1 ) / T( width ) );
+        kernel.column.assign( height, T( 1 ) / T( height ) );
+    }
+    else
+    {
+        kernel.row.assign( width, T( 1 ) );
+        kernel.column.assign( height, T( 1 ) );
+    }
+    return kernel;
+}
+
+// Derivative along x or y, smoothed across it, value grows to the right or downwards
+template<typename T>
+SeparableKernel<T> sobelKernel( bool horizontal )
+{
+    SeparableKernel<T> kernel;
+    std::vector<T> derivative { T( -1 ), T( 0 ), T( 1 ) }, smoothing { T( 1 ), T( 2 ), T( 1 ) };
+    kernel.row = horizontal ? derivative : smoothing;
+    kernel.column = horizontal ? smoothing : derivative;
+    return kernel;
+}
+
+// Finds factors of kernel of rank 1, returns false, if kernel isn't separable
+// Floating kernels are compared with tolerance of rounding, integer factors must be exact
+template<typename T>
+bool separate( const MatrixBase<T> &kernel, SeparableKernel<T> &result )
+{
+    if constexpr( !std::is_arithmetic_v<T> )
+    {
+        return false;
+    }
+    else
+    {
+        if( kernel.empty() )
+            return false;
+
+        // Row and column of pivot are the factors, column is divided by pivot
+        // Largest value is the most accurate pivot for floating kernels, smallest one keeps integer factors exact
+        int pivotX = -1, pivotY = -1;
+        T largest = T(), pivot = T();
+        for( int i = 0; i < kernel.h(); ++i )
+        {
+            for( int j = 0; j < kernel.w(); ++j )
+            {
+                auto value = Abs( *kernel( j, i ) );
+                if( value <= T() )
+                    continue;
+
+                largest = Max( largest, value );
+                if( pivotX < 0 || ( std::is_floating_point_v<T> ? value > pivot : value < pivot ) )
+                {
+                    pivot = value;
+                    pivotX = j;
+                    pivotY = i;
+                }
+            }
+        }
+
+        if( pivotX < 0 )
+            return false;
+
+        pivot = *kernel( pivotX, pivotY );
+        result.row.resize( kernel.w() );
+        result.column.resize( kernel.h() );
+        for( int j = 0; j < kernel.w(); ++j )
+            result.row[j] = *kernel( j, pivotY );
+        for( int i = 0; i < kernel.h(); ++i )
+            result.column[i] = *kernel( pivotX, i ) / pivot;
+
+        T tolerance = T();
+        if constexpr( std::is_floating_point_v<T> )
+            tolerance = largest * std::numeric_limits<T>::epsilon() * 64;
+
+        for( int i = 0; i < kernel.h(); ++i )
+        {
+            for( int j = 0; j < kernel.w(); ++j )
+            {
+                if( Abs( *kernel( j, i ) - result.column[i] * result.row[j] ) > tolerance )
+                    return false;
+            }
+        }
+        return true;
+    }
+}
+
+// Kernels of lines, every value of result is computed the same way, so compilers vectorize them
+template<typename T>
+struct FilterLine
+{
+    // result[x] += sum( weights[k] * inputs[k][x] ), rows and shifted copies of a line are added the same way
+    // Symmetric weights, as gaussian and box have, are multiplied once for both inputs of a pair
+    static void accumulate( const T *const *inputs, const T *weights, int taps, T *result, int count )
+    {
+        int pairs = symmetric( weights, taps ) ? taps / 2 : 0;
+
+        int x = 0;
+        for( ; x + FILTER_LANES <= count; x += FILTER_LANES )
+        {
+            T sums[FILTER_LANES];
+            for( int l = 0; l < FILTER_LANES; ++l )
+                sums[l] = result[x + l];
+
+            for( int k = 0; k < pairs; ++k )
+            {
+                T weight = weights[k];
+                auto first = inputs[k] + x, second = inputs[taps - 1 - k] + x;
+                for( int l = 0; l < FILTER_LANES; ++l )
+                    sums[l] += weight * ( first[l] + second[l] );
+            }
+
+            for( int k = pairs; k < taps - pairs; ++k )
+            {
+                T weight = weights[k];
+                auto input = inputs[k] + x;
+                for( int l = 0; l < FILTER_LANES; ++l )
+                    sums[l] += weight * input[l];
+            }
+
+            for( int l = 0; l < FILTER_LANES; ++l )
+                result[x + l] = sums[l];
+        }
+
+        for( ; x < count; ++x )
+        {
+            T sum = result[x];
+            for( int k = 0; k < taps; ++k )
+                sum += weights[k] * inputs[k][x];
+            result[x] = sum;
+        }
+    }
+
+    // result[x] += sum( weights[k] * input[x + k] ), 'input' has count + taps - 1 values
+    static void accumulate( const T *input, const T *weights, int taps, T *result, int count )
+    {
+        std::vector<const T *> inputs( taps );
+        for( int k = 0; k < taps; ++k )
+            inputs[k] = input + k;
+        accumulate( inputs.data(), weights, taps, result, count );
+    }
+
+    // Same as accumulate, but overwrites result, kernels with equal weights use running sum
+    static void correlate( const T *input, const std::vector<T> &weights, T *result, int count )
+    {
+        int taps = weights.size();
+        if( uniform( weights ) )
+        {
+            T weight = weights[0], sum = T();
+            for( int k = 0; k < taps; ++k )
+                sum += input[k];
+            result[0] = sum * weight;
+            for( int x = 1; x < count; ++x )
+            {
+                sum += input[x + taps - 1];
+                sum -= input[x - 1];
+                result[x] = sum * weight;
+            }
+            return;
+        }
+
+        for( int x = 0; x < count; ++x )
+            result[x] = T();
+        accumulate( input, weights.data(), taps, result, count );
+    }
+
+    static bool symmetric( const T *weights, int taps )
+    {
+        for( int k = 0; k < taps / 2; ++k )
+        {
+            if( !( weights[k] == weights[taps - 1 - k] ) )
+                return false;
+        }
+        return taps > 1;
+    }
+
+    static bool uniform( const std::vector<T> &weights )
+    {
+        if( weights.size() < FILTER_RUNNING_SUM )
+            return false;
+
+        for( auto &weight : weights )
+        {
+            if( !( weight == weights[0] ) )
+                return false;
+        }
+        return true;
+    }
+
+    // Copies line with 'before' and 'after' values of border around it
+    static void pad( const T *line, int size, int before, int after, Border border, T *result )
+    {
+        for( int x = -before; x < 0; ++x )
+        {
+            int index = borderIndex( x, size, border );
+            *result++ = index < 0 ? T() : line[index];
+        }
+
+        ::copy( result, line, size * sizeof( T ) );
+        result += size;
+
+        for( int x = size; x < size + after; ++x )
+        {
+            int index = borderIndex( x, size, border );
+            *result++ = index < 0 ? T() : line[index];
+        }
+    }
+};
+
+// Filters rows with 'kernel.row', then columns with 'kernel.column', result has the size of source
+// Kernel isn't flipped, as in MatrixArithmetic::convolution, values outside of source are defined by 'border'
+// Bands of lines are processed on several threads
+template<typename T>
+void filter( const MatrixBase<T> &source, MatrixBase<T> &result, const SeparableKernel<T> &kernel, Border border )
+{
+    makeException( !kernel.row.empty() && !kernel.column.empty() );
+
+    int width = source.w(), height = source.h();
+    if( &result == &source )
+    {
+        MatrixBase<T> temporary;
+        filter( source, temporary, kernel, border );
+        result = std::move( temporary );
+        return;
+    }
+
+    if( result.w() != width || result.h() != height )
+        result.reset( width, height );
+    if( source.empty() )
+        return;
+
+    int taps = kernel.row.size(), anchor = taps / 2;
+    MatrixBase<T> rows( width, height );
+    parallelFor( height, [&]( size_t begin, size_t end )
+    {
+        std::vector<T> padded( width + taps - 1 );
+        for( size_t i = begin; i < end; ++i )
+        {
+            FilterLine<T>::pad( source( 0, i ), width, anchor, taps - 1 - anchor, border, padded.data() );
+            FilterLine<T>::correlate( padded.data(), kernel.row, rows( 0, i ), width );
+        }
+    }, 8 );
+
+    taps = kernel.column.size();
+    anchor = taps / 2;
+    bool running = FilterLine<T>::uniform( kernel.column );
+    parallelFor( height, [&]( size_t begin, size_t end )
+    {
+        auto line = [&]( int i ) -> const T *
+        {
+            int index = borderIndex( i, height, border );
+            return index < 0 ? nullptr : rows( 0, index );
+        };
+
+        std::vector<const T *> inputs;
+        std::vector<T> weights, sums;
+        for( int i = begin; i < int( end ); ++i )
+        {
+            auto output = result( 0, i );
+            if( !running )
+            {
+                // Rows of zero border add nothing
+                inputs.clear();
+                weights.clear();
+                for( int k = 0; k < taps; ++k )
+                {
+                    if( auto input = line( i + k - anchor ) )
+                    {
+                        inputs.push_back( input );
+                        weights.push_back( kernel.column[k] );
+                    }
+                }
+
+                for( int x = 0; x < width; ++x )
+                    output[x] = T();
+                FilterLine<T>::accumulate( inputs.data(), weights.data(), inputs.size(), output, width );
+                continue;
+            }
+
+            // Running sums of columns are started once per band
+            if( sums.empty() )
+            {
+                sums.assign( width, T() );
+                for( int k = 0; k < taps; ++k )
+                {
+                    if( auto input = line( i + k - anchor ) )
+                    {
+                        for( int x = 0; x < width; ++x )
+                            sums[x] += input[x];
+                    }
+                }
+            }
+            else
+            {
+                auto added = line( i + taps - 1 - anchor ), removed = line( i - 1 - anchor );
+                for( int x = 0; added && x < width; ++x )
+                    sums[x] += added[x];
+                for( int x = 0; removed && x < width; ++x )
+                    sums[x] -= removed[x];
+            }
+
+            T weight = kernel.column[0];
+            for( int x = 0; x < width; ++x )
+                output[x] = sums[x] * weight;
+        }
+    }, 8 );
+}
+
+// Filters with matrix kernel, anchor is at kernel.w() / 2, kernel.h() / 2
+// Separable kernels are filtered in two passes, others add all taps to every line of result at once
+template<typename T>
+void filter( const MatrixBase<T> &source, MatrixBase<T> &result, const MatrixBase<T> &kernel, Border border )
+{
+    makeException( !kernel.empty() );
+
+    SeparableKernel<T> factors;
+    if( separate( kernel, factors ) )
+    {
+        filter( source, result, factors, border );
+        return;
+    }
+
+    int width = source.w(), height = source.h();
+    if( &result == &source || &result == &kernel )
+    {
+        MatrixBase<T> temporary;
+        filter( source, temporary, kernel, border );
+        result = std::move( temporary );
+        return;
+    }
+
+    if( result.w() != width || result.h() != height )
+        result.reset( width, height );
+    if( source.empty() )
+        return;
+
+    // Rows are padded once, taps are shifted rows of padded image
+    int taps = kernel.w(), anchorX = taps / 2, anchorY = kernel.h() / 2;
+    MatrixBase<T> padded( width + taps - 1, height );
+    parallelFor( height, [&]( size_t begin, size_t end )
+    {
+        for( size_t i = begin; i < end; ++i )
+            FilterLine<T>::pad( source( 0, i ), width, anchorX, taps - 1 - anchorX, border, padded( 0, i ) );
+    }, 8 );
+
+    parallelFor( height, [&]( size_t begin, size_t end )
+    {
+        std::vector<const T *> inputs;
+        std::vector<T> weights;
+        for( int i = begin; i < int( end ); ++i )
+        {
+            inputs.clear();
+            weights.clear();
+            for( int k = 0; k < kernel.h(); ++k )
+            {
+                int index = borderIndex( i + k - anchorY, height, border );
+                for( int j = 0; index >= 0 && j < taps; ++j )
+                {
+                    inputs.push_back( padded( 0, index ) + j );
+                    weights.push_back( *kernel( j, k ) );
+                }
+            }
+
+            auto output = result( 0, i );
+            for( int x = 0; x < width; ++x )
+                output[x] = T();
+            FilterLine<T>::accumulate( inputs.data(), weights.data(), inputs.size(), output, width );
+        }
+    }, 8 );
+}
+
+// Convolution without border, result is smaller than source by size of kernel minus 1
+// Result is reused, if it already has the needed size
+template<typename T>
+void validConvolution( const MatrixBase<T> &source, const MatrixBase<T> &kernel, MatrixBase<T> &result )
+{
+    // Kernel size must not exceed matrix size
+    makeException( kernel.w() <= source.w() && kernel.h() <= source.h() );
+
+    if( &result == &source || &result == &kernel )
+    {
+        MatrixBase<T> temporary;
+        validConvolution( source, kernel, temporary );
+        result = std::move( temporary );
+        return;
+    }
+
+    int width = source.w() - kernel.w() + 1, height = source.h() - kernel.h() + 1;
+    if( result.w() != width || result.h() != height )
+        result.reset( width, height );
+    if( result.empty() || kernel.empty() )
+        return;
+
+    // Separable kernels filter rows into temporary matrix, then combine its rows
+    SeparableKernel<T> factors;
+    bool separable = separate( kernel, factors );
+
+    // Large kernels, that aren't separable, are applied through spectra, when that needs less operations
+    if constexpr( std::is_floating_point_v<T> )
+    {
+        if( !separable && fourierConvolutionFaster( source.w(), source.h(), kernel.w(), kernel.h() ) )
+        {
+            fourierConvolution( source, kernel, result );
+            return;
+        }
+    }
+
+    MatrixBase<T> rows;
+    if( separable )
+    {
+        rows.reset( width, source.h() );
+        parallelFor( source.h(), [&]( size_t begin, size_t end )
+        {
+            for( size_t i = begin; i < end; ++i )
+                FilterLine<T>::correlate( source( 0, i ), factors.row, rows( 0, i ), width );
+        }, 8 );
+    }
+
+    parallelFor( height, [&]( size_t begin, size_t end )
+    {
+        std::vector<const T *> inputs;
+        std::vector<T> weights;
+        for( int i = begin; i < int( end ); ++i )
+        {
+            inputs.clear();
+            weights.clear();
+            for( int k = 0; k < kernel.h(); ++k )
+            {
+                if( separable )
+                {
+                    inputs.push_back( rows( 0, i + k ) );
+                    weights.push_back( factors.column[k] );
+                    continue;
+                }
+
+                for( int j = 0; j < kernel.w(); ++j )
+                {
+                    inputs.push_back( source( j, i + k ) );
+                    weights.push_back( *kernel( j, k ) );
+                }
+            }
+
+            auto output = result( 0, i );
+            for( int x = 0; x < width; ++x )
+                output[x] = T();
+            FilterLine<T>::accumulate( inputs.data(), weights.data(), inputs.size(), output, width );
+        }
+    }, 8 );
+}
@@ -0,0 +1 @@
+#include "FixedMatrix.h"
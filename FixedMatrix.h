@@ -0,0 +1,461 @@
+#pragma once
+
+#include <type_traits>
+#include <utility>
+#include <cmath>
+
+#include "Exception.h"
+#include "Matrix2D.h"
+#include "Matrix3D.h"
+#include "Matrix4D.h"
+#include "Matrix.h"
+#include "Basic.h"
+
+template<typename F, int... K>
+constexpr void fixedUnroll( F &f, std::integer_sequence<int, K...> )
+{
+    ( f( std::integral_constant<int, K>() ), ... );
+}
+
+// Calls 'f' with std::integral_constant of every index in [0, N), every call is a separate statement, so loop is unrolled
+template<int N, typename F>
+constexpr void fixedUnroll( F f )
+{
+    fixedUnroll( f, std::make_integer_sequence<int, N>() );
+}
+
+template<typename T, int N>
+class FixedCholesky;
+
+// Matrix with R lines and C columns, that are known at compile time
+// Values are stored inside of object, so small matrices don't need allocations and can be kept on stack
+// Loops over columns are unrolled, loops over lines have constant bounds, so compilers unroll them for small matrices
+template<typename T, int R, int C>
+class FixedMatrix
+{
+    static_assert( R > 0 && C > 0 );
+
+private:
+    // Line from 'k' with the largest absolute value in column 'k'
+    int pivot( int k ) const
+    {
+        int result = k;
+        for( int i = k + 1; i < R; ++i )
+        {
+            if( std::abs( values[i][k] ) > std::abs( values[result][k] ) )
+                result = i;
+        }
+        return result;
+    }
+
+    void exchange( int a, int b )
+    {
+        fixedUnroll<C>( [&]( auto j )
+        {
+            std::swap( values[a][j], values[b][j] );
+        } );
+    }
+public:
+    T values[R][C];
+
+    constexpr FixedMatrix() : values{}
+    {}
+
+    explicit FixedMatrix( const MatrixBase<T> &matrix ) : values{}
+    {
+        // Matrix must have the same dimensions
+        makeException( matrix.w() == C && matrix.h() == R );
+
+        for( int i = 0; i < R; ++i )
+        {
+            const T *line = matrix( 0, i );
+            fixedUnroll<C>( [&]( auto j )
+            {
+                values[i][j] = line[j];
+            } );
+        }
+    }
+
+    constexpr explicit FixedMatrix( const Matrix2D &m ) : values{}
+    {
+        static_assert( R == 2 && C == 2 );
+        values[0][0] = m.a00; values[0][1] = m.a01;
+        values[1][0] = m.a10; values[1][1] = m.a11;
+    }
+
+    constexpr explicit FixedMatrix( const Matrix3D &m ) : values{}
+    {
+        static_assert( R == 3 && C == 3 );
+        values[0][0] = m.a00; values[0][1] = m.a01; values[0][2] = m.a02;
+        values[1][0] = m.a10; values[1][1] = m.a11; values[1][2] = m.a12;
+        values[2][0] = m.a20; values[2][1] = m.a21; values[2][2] = m.a22;
+    }
+
+    constexpr explicit FixedMatrix( const Matrix4D &m ) : values{}
+    {
+        static_assert( R == 4 && C == 4 );
+        values[0][0] = m.a00; values[0][1] = m.a01; values[0][2] = m.a02; values[0][3] = m.a03;
+        values[1][0] = m.a10; values[1][1] = m.a11; values[1][2] = m.a12; values[1][3] = m.a13;
+        values[2][0] = m.a20; values[2][1] = m.a21; values[2][2] = m.a22; values[2][3] = m.a23;
+        values[3][0] = m.a30; values[3][1] = m.a31; values[3][2] = m.a32; values[3][3] = m.a33;
+    }
+
+    // Copy in dynamic matrix, MatrixArithmetic can be constructed from it
+    MatrixBase<T> matrix() const
+    {
+        MatrixBase<T> result( C, R );
+        for( int i = 0; i < R; ++i )
+        {
+            T *line = result( 0, i );
+            fixedUnroll<C>( [&]( auto j )
+            {
+                line[j] = values[i][j];
+            } );
+        }
+        return result;
+    }
+
+    constexpr Matrix2D matrix2D() const
+    {
+        static_assert( R == 2 && C == 2 );
+        return Matrix2D( values[0][0], values[0][1],
+                         values[1][0], values[1][1] );
+    }
+
+    constexpr Matrix3D matrix3D() const
+    {
+        static_assert( R == 3 && C == 3 );
+        return Matrix3D( values[0][0], values[0][1], values[0][2],
+                         values[1][0], values[1][1], values[1][2],
+                         values[2][0], values[2][1], values[2][2] );
+    }
+
+    constexpr Matrix4D matrix4D() const
+    {
+        static_assert( R == 4 && C == 4 );
+        return Matrix4D( values[0][0], values[0][1], values[0][2], values[0][3],
+                         values[1][0], values[1][1], values[1][2], values[1][3],
+                         values[2][0], values[2][1], values[2][2], values[2][3],
+                         values[3][0], values[3][1], values[3][2], values[3][3] );
+    }
+
+    static constexpr int w()
+    {
+        return C;
+    }
+
+    static constexpr int h()
+    {
+        return R;
+    }
+
+    // Value of column 'j' in line 'i', indices aren't checked
+    constexpr const T &operator()( int j, int i ) const
+    {
+        return values[i][j];
+    }
+
+    constexpr T &operator()( int j, int i )
+    {
+        return values[i][j];
+    }
+
+    constexpr FixedMatrix operator+() const
+    {
+        return *this;
+    }
+
+    constexpr FixedMatrix operator+( const FixedMatrix &a ) const
+    {
+        FixedMatrix result = *this;
+        return result += a;
+    }
+
+    constexpr FixedMatrix &operator+=( const FixedMatrix &a )
+    {
+        for( int i = 0; i < R; ++i )
+        {
+            fixedUnroll<C>( [&]( auto j )
+            {
+                values[i][j] += a.values[i][j];
+            } );
+        }
+        return *this;
+    }
+
+    constexpr FixedMatrix operator-() const
+    {
+        FixedMatrix result;
+        return result -= *this;
+    }
+
+    constexpr FixedMatrix operator-( const FixedMatrix &a ) const
+    {
+        FixedMatrix result = *this;
+        return result -= a;
+    }
+
+    constexpr FixedMatrix &operator-=( const FixedMatrix &a )
+    {
+        for( int i = 0; i < R; ++i )
+        {
+            fixedUnroll<C>( [&]( auto j )
+            {
+                values[i][j] -= a.values[i][j];
+            } );
+        }
+        return *this;
+    }
+
+    constexpr FixedMatrix operator*( const T &k ) const
+    {
+        FixedMatrix result = *this;
+        return result *= k;
+    }
+
+    constexpr FixedMatrix &operator*=( const T &k )
+    {
+        for( int i = 0; i < R; ++i )
+        {
+            fixedUnroll<C>( [&]( auto j )
+            {
+                values[i][j] *= k;
+            } );
+        }
+        return *this;
+    }
+
+    // Line of result is accumulated from lines of 'a', so the unrolled loop reads and writes contiguous values
+    template<int K>
+    constexpr FixedMatrix<T, R, K> operator*( const FixedMatrix<T, C, K> &a ) const
+    {
+        FixedMatrix<T, R, K> result;
+        for( int i = 0; i < R; ++i )
+        {
+            for( int k = 0; k < C; ++k )
+            {
+                T factor = values[i][k];
+                fixedUnroll<K>( [&]( auto j )
+                {
+                    result.values[i][j] += factor * a.values[k][j];
+                } );
+            }
+        }
+        return result;
+    }
+
+    constexpr FixedMatrix &operator*=( const FixedMatrix<T, C, C> &a )
+    {
+        return *this = *this * a;
+    }
+
+    constexpr FixedMatrix<T, C, R> transpose() const
+    {
+        FixedMatrix<T, C, R> result;
+        for( int i = 0; i < R; ++i )
+        {
+            fixedUnroll<C>( [&]( auto j )
+            {
+                result.values[j][i] = values[i][j];
+            } );
+        }
+        return result;
+    }
+
+    // Gaussian elimination with partial pivoting
+    T det() const
+    {
+        static_assert( R == C && std::is_floating_point_v<T> );
+
+        FixedMatrix a = *this;
+        T result = T( 1 );
+        for( int k = 0; k < R; ++k )
+        {
+            int p = a.pivot( k );
+            if( a.values[p][k] == T() )
+                return T();
+
+            if( p != k )
+            {
+                a.exchange( k, p );
+                result = -result;
+            }
+            result *= a.values[k][k];
+
+            for( int i = k + 1; i < R; ++i )
+            {
+                T factor = a.values[i][k] / a.values[k][k];
+                fixedUnroll<C>( [&]( auto j )
+                {
+                    a.values[i][j] -= factor * a.values[k][j];
+                } );
+            }
+        }
+        return result;
+    }
+
+    // Gauss-Jordan elimination with partial pivoting
+    FixedMatrix inverse() const
+    {
+        static_assert( R == C && std::is_floating_point_v<T> );
+
+        FixedMatrix a = *this, result = Identity();
+        for( int k = 0; k < R; ++k )
+        {
+            int p = a.pivot( k );
+
+            // Matrix is singular and cannot be inverted
+            makeException( a.values[p][k] != T() );
+
+            if( p != k )
+            {
+                a.exchange( k, p );
+                result.exchange( k, p );
+            }
+
+            T scale = T( 1 ) / a.values[k][k];
+            fixedUnroll<C>( [&]( auto j )
+            {
+                a.values[k][j] *= scale;
+                result.values[k][j] *= scale;
+            } );
+
+            for( int i = 0; i < R; ++i )
+            {
+                T factor = a.values[i][k];
+                if( i == k || factor == T() )
+                    continue;
+
+                fixedUnroll<C>( [&]( auto j )
+                {
+                    a.values[i][j] -= factor * a.values[k][j];
+                    result.values[i][j] -= factor * result.values[k][j];
+                } );
+            }
+        }
+        return result;
+    }
+
+    FixedCholesky<T, R> cholesky() const
+    {
+        return FixedCholesky<T, R>( *this );
+    }
+
+    static constexpr FixedMatrix Zero()
+    {
+        return FixedMatrix();
+    }
+
+    static constexpr FixedMatrix Identity()
+    {
+        static_assert( R == C );
+
+        FixedMatrix result;
+        for( int i = 0; i < R; ++i )
+            result.values[i][i] = T( 1 );
+        return result;
+    }
+};
+
+template<typename T, int R, int C>
+constexpr FixedMatrix<T, R, C> operator*( const T &k, const FixedMatrix<T, R, C> &a )
+{
+    return a * k;
+}
+
+// Cholesky decomposition of symmetric positive definite matrix: matrix = L * L^T, only lower triangle of matrix is read
+// Takes half of operations of LU decomposition, normal equations of least squares have such matrices
+template<typename T, int N>
+class FixedCholesky
+{
+    static_assert( std::is_floating_point_v<T> );
+
+private:
+    FixedMatrix<T, N, N> lower;
+    bool definite;
+public:
+    explicit FixedCholesky( const FixedMatrix<T, N, N> &matrix ) : definite( true )
+    {
+        for( int j = 0; j < N; ++j )
+        {
+            T diagonal = matrix.values[j][j];
+            for( int k = 0; k < j; ++k )
+                diagonal -= lower.values[j][k] * lower.values[j][k];
+
+            if( !( diagonal > T() ) )
+            {
+                definite = false;
+                return;
+            }
+
+            T root = std::sqrt( diagonal ), scale = T( 1 ) / root;
+            lower.values[j][j] = root;
+            for( int i = j + 1; i < N; ++i )
+            {
+                T value = matrix.values[i][j];
+                for( int k = 0; k < j; ++k )
+                    value -= lower.values[i][k] * lower.values[j][k];
+                lower.values[i][j] = value * scale;
+            }
+        }
+    }
+
+    // False, if matrix isn't positive definite, then it has no decomposition
+    bool positive() const
+    {
+        return definite;
+    }
+
+    // L, values above diagonal are zero
+    const FixedMatrix<T, N, N> &factor() const
+    {
+        return lower;
+    }
+
+    // Solves matrix * x = b for every column of 'b'
+    template<int K>
+    FixedMatrix<T, N, K> solve( const FixedMatrix<T, N, K> &b ) const
+    {
+        // Matrix isn't positive definite
+        makeException( definite );
+
+        // L * y = b, then L^T * x = y, lines of 'x' are updated as a whole
+        FixedMatrix<T, N, K> x = b;
+        for( int i = 0; i < N; ++i )
+        {
+            for( int k = 0; k < i; ++k )
+            {
+                T factor = lower.values[i][k];
+                fixedUnroll<K>( [&]( auto j )
+                {
+                    x.values[i][j] -= factor * x.values[k][j];
+                } );
+            }
+
+            T scale = T( 1 ) / lower.values[i][i];
+            fixedUnroll<K>( [&]( auto j )
+            {
+                x.values[i][j] *= scale;
+            } );
+        }
+
+        for( int i = N - 1; i >= 0; --i )
+        {
+            for( int k = i + 1; k < N; ++k )
+            {
+                T factor = lower.values[k][i];
+                fixedUnroll<K>( [&]( auto j )
+                {
+                    x.values[i][j] -= factor * x.values[k][j];
+                } );
+            }
+
+            T scale = T( 1 ) / lower.values[i][i];
+            fixedUnroll<K>( [&]( auto j )
+            {
+                x.values[i][j] *= scale;
+            } );
+        }
+        return x;
+    }
+};
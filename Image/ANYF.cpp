@@ -1,10 +1,12 @@
 #include "Image/ANYF.h"
 
+#include <utility>
+
 #include "Image/PixelIO.h"
 
 namespace ImageConvert
 {
-void sync( unsigned bytes, const Format &dstFmt, Reference &destination )
+void sync( size_t bytes, const Format &dstFmt, Reference &destination )
 {
     if( destination.w != dstFmt.w || destination.h != dstFmt.h || destination.bytes < bytes )
     {
@@ -35,21 +37,191 @@ void sync( const Format &dstFmt, Reference &destination )
     }
 }
 
-Misc::Misc( unsigned s, bool x, bool y, std::optional<Pixel> t, const PixelFormat &pfmt ) : Compression( s, pfmt ),
-    transparent( std::move( t ) ), fixX( x ), fixY( y )
+// Pixels are moved by blocks of this size, when axes are swapped
+constexpr unsigned orientTile = 32;
+
+template<unsigned bytes>
+struct Sample
+{
+    uint8_t data[bytes];
+};
+
+// Calls 'move( destinationLine, x, sourceLine, sourceX )' for every pixel of destination
+// Source pixel is found by swapping axes, if 'transpose' is set, and then mirroring them
+template<typename Move>
+static void orientLines( const Format &srcFmt, const uint8_t *source, const Format &dstFmt, uint8_t *destination,
+                         bool flipX, bool flipY, bool transpose, const Move &move )
+{
+    unsigned width = Abs( dstFmt.w );
+    unsigned height = Abs( dstFmt.h );
+    unsigned srcWidth = Abs( srcFmt.w );
+    unsigned srcHeight = Abs( srcFmt.h );
+    size_t srcStride = srcFmt.lineSize();
+    size_t dstStride = dstFmt.lineSize();
+
+    auto sourceX = [&]( unsigned x )
+    {
+        return flipX ? srcWidth - 1 - x : x;
+    };
+
+    auto sourceY = [&]( unsigned y )
+    {
+        return flipY ? srcHeight - 1 - y : y;
+    };
+
+    if( !transpose )
+    {
+        for( unsigned y = 0; y < height; ++y )
+        {
+            auto line = destination + y * dstStride;
+            auto sourceLine = source + sourceY( y ) * srcStride;
+            for( unsigned x = 0; x < width; ++x )
+                move( line, x, sourceLine, sourceX( x ) );
+        }
+        return;
+    }
+
+    // Lines of a tile are read from the source columns, tiles keep both sides in cache
+    for( unsigned tileY = 0; tileY < height; tileY += orientTile )
+    {
+        for( unsigned tileX = 0; tileX < width; tileX += orientTile )
+        {
+            unsigned endY = Min( tileY + orientTile, height );
+            unsigned endX = Min( tileX + orientTile, width );
+            for( unsigned y = tileY; y < endY; ++y )
+            {
+                auto line = destination + y * dstStride;
+                auto column = sourceX( y );
+                for( unsigned x = tileX; x < endX; ++x )
+                    move( line, x, source + sourceY( x ) * srcStride, column );
+            }
+        }
+    }
+}
+
+// Moves pixels of 'source' to 'destination' of the same pixel format with mirroring and swapping of axes
+static void orient( const Format &srcFmt, const Reference &src, const Format &dstFmt, Reference &dst, bool flipX, bool flipY, bool transpose )
+{
+    makeException( srcFmt.bits == dstFmt.bits && srcFmt.bits > 0 );
+    if( transpose )
+        makeException( Abs( srcFmt.w ) == Abs( dstFmt.h ) && Abs( srcFmt.h ) == Abs( dstFmt.w ) );
+    else
+        makeException( Abs( srcFmt.w ) == Abs( dstFmt.w ) && Abs( srcFmt.h ) == Abs( dstFmt.h ) );
+
+    unsigned bits = srcFmt.bits;
+    unsigned height = Abs( dstFmt.h );
+    size_t srcStride = srcFmt.lineSize();
+    size_t dstStride = dstFmt.lineSize();
+
+    makeException( src.bytes >= srcFmt.offset + Abs( srcFmt.h ) * srcStride );
+    makeException( dst.bytes >= dstFmt.offset + height * dstStride );
+
+    auto source = ( const uint8_t * )src.link + srcFmt.offset;
+    auto destination = ( uint8_t * )dst.link + dstFmt.offset;
+
+    // Lines are copied as they are
+    if( !transpose && !flipX )
+    {
+        size_t lineBytes = sizeSum( sizeProduct( Abs( dstFmt.w ), bits ), 7 ) / 8;
+        if( !flipY && srcStride == dstStride )
+        {
+            copy( destination, source, height * dstStride );
+            return;
+        }
+
+        for( unsigned y = 0; y < height; ++y )
+        {
+            unsigned sourceY = flipY ? height - 1 - y : y;
+            copy( destination + y * dstStride, source + sourceY * srcStride, lineBytes );
+        }
+        return;
+    }
+
+    auto run = [&]( const auto & move )
+    {
+        orientLines( srcFmt, source, dstFmt, destination, flipX, flipY, transpose, move );
+    };
+
+    auto whole = [&]( auto sample )
+    {
+        using S = decltype( sample );
+        run( []( uint8_t * line, unsigned x, const uint8_t * sourceLine, unsigned sourceX )
+        {
+            ( ( S * )line )[x] = ( ( const S * )sourceLine )[sourceX];
+        } );
+    };
+
+    switch( bits )
+    {
+    case 8:
+        whole( Sample<1>() );
+        return;
+    case 16:
+        whole( Sample<2>() );
+        return;
+    case 24:
+        whole( Sample<3>() );
+        return;
+    case 32:
+        whole( Sample<4>() );
+        return;
+    case 48:
+        whole( Sample<6>() );
+        return;
+    case 64:
+        whole( Sample<8>() );
+        return;
+    default:
+        break;
+    }
+
+    if( bits % 8 == 0 )
+    {
+        size_t bytes = bits / 8;
+        run( [bytes]( uint8_t * line, unsigned x, const uint8_t * sourceLine, unsigned sourceX )
+        {
+            copy( line + x * bytes, sourceLine + sourceX * bytes, bytes );
+        } );
+        return;
+    }
+
+    // Pixels, that don't occupy whole bytes
+    run( [bits]( uint8_t * line, unsigned x, const uint8_t * sourceLine, unsigned sourceX )
+    {
+        BitList value;
+        const uint8_t *from = sourceLine + size_t( sourceX ) * bits / 8;
+        long long unsigned fromBit = size_t( sourceX ) * bits % 8;
+        readBits( from, fromBit, bits, value );
+
+        uint8_t *to = line + size_t( x ) * bits / 8;
+        long long unsigned toBit = size_t( x ) * bits % 8;
+        writeBits( to, toBit, bits, value );
+    } );
+}
+
+Misc::Misc( size_t s, bool x, bool y, std::optional<Pixel> t, const PixelFormat &pfmt, bool r ) : Compression( s, pfmt ),
+    transparent( std::move( t ) ), fixX( x ), fixY( y ), transpose( r )
 {}
 
 void Misc::compress( Format &fmt, const Reference &source, Reference &destination )
 {
     makeException( fmt.compression.front().get() == this );
 
-    PixelReader sourcePixelReader( fmt, source );
+    auto srcFmt = fmt;
+    srcFmt.compression.clear();
 
     auto id = fmt.id( 'A' );
 
     fmt.offset = 0;
     copy( fmt );
-    size = fmt.bufferSize( this );
+
+    // Alpha channel is replaced by transparent pixel
+    if( transparent )
+    {
+        makeException( id );
+        fmt.channels.erase( fmt.channels.begin() + *id );
+        fmt.calculateBits();
+    }
 
     if( fixX )
         fmt.w = -fmt.w;
@@ -57,68 +229,61 @@ void Misc::compress( Format &fmt, const Reference &source, Reference &destinatio
     if( fixY )
         fmt.h = -fmt.h;
 
-    sync( fmt, destination );
-
-    PixelWriter destinationPixelWriter( fmt, destination );
+    bool flipX = fmt.w < 0;
+    bool flipY = fmt.h < 0;
 
-    auto getPixelLn = [&]( Pixel & pixel )
-    {
-        sourcePixelReader.getPixelLn( pixel );
-    };
+    fmt.w = Abs( fmt.w );
+    fmt.h = Abs( fmt.h );
 
-    auto putPixelLn = [&]( const Pixel & pixel )
-    {
-        destinationPixelWriter.putPixelLn( pixel );
-    };
+    if( transpose )
+        std::swap( fmt.w, fmt.h );
 
-    unsigned width = Abs( fmt.w );
-    unsigned height = Abs( fmt.h );
+    size = fmt.bufferSize( this );
+    sync( fmt, destination );
 
-    std::vector<std::vector<Pixel>> image( height, std::vector<Pixel>( width ) );
-    for( unsigned y = 0; y < height; ++y )
+    if( !transparent )
     {
-        for( unsigned x = 0; x < width; ++x )
-        {
-            auto &pixel = image[y][x];
-            getPixelLn( pixel );
-
-            if( transparent )
-            {
-                makeException( id );
-                auto position = pixel.begin();
-                position += *id;
-                pixel.erase( position );
-            }
-        }
+        orient( srcFmt, source, fmt, destination, flipX, flipY, transpose );
+        return;
     }
 
-    bool flipX = fmt.w < 0;
-    bool flipY = fmt.h < 0;
+    auto keyedFmt = fmt;
+    keyedFmt.compression.clear();
+    keyedFmt.w = Abs( srcFmt.w );
+    keyedFmt.h = Abs( srcFmt.h );
 
-    for( unsigned y = 0; y < height; ++y )
+    Reference keyed;
+    keyed.fill();
+    sync( keyedFmt, keyed );
+
+    PixelReader sourcePixelReader( srcFmt, source );
+    PixelWriter keyedPixelWriter( keyedFmt, keyed );
+
+    Pixel pixel;
+    for( size_t i = sizeProduct( Abs( srcFmt.w ), Abs( srcFmt.h ) ); i > 0; --i )
     {
-        for( unsigned x = 0; x < width; ++x )
-        {
-            unsigned fx = flipX ? ( width - 1 - x ) : x;
-            unsigned fy = flipY ? ( height - 1 - y ) : y;
-            putPixelLn( image[fy][fx] );
-        }
+        makeException( sourcePixelReader.getPixelLn( pixel ) );
+        pixel.erase( pixel.begin() + *id );
+        makeException( keyedPixelWriter.putPixelLn( pixel ) );
     }
 
-    fmt.w = Abs( fmt.w );
-    fmt.h = Abs( fmt.h );
+    orient( keyedFmt, keyed, fmt, destination, flipX, flipY, transpose );
 }
 
 void Misc::decompress( Format &fmt, const Reference &source, Reference &destination ) const
 {
     makeException( fmt.compression.front().get() == this );
 
-    PixelReader sourcePixelReader( fmt, source );
+    auto srcFmt = fmt;
+    srcFmt.compression.clear();
 
     fmt.offset = 0;
     fmt.compression.pop_front();
     fmt.copy( *this );
 
+    if( transpose )
+        std::swap( fmt.w, fmt.h );
+
     if( fixX )
         fmt.w = -fmt.w;
 
@@ -127,48 +292,44 @@ void Misc::decompress( Format &fmt, const Reference &source, Reference &destinat
 
     sync( fmt, destination );
 
-    PixelWriter destinationPixelWriter( fmt, destination );
-
-    auto getPixelLn = [&]( Pixel & pixel )
+    if( !transparent )
     {
-        sourcePixelReader.getPixelLn( pixel );
-    };
-
-    auto putPixelLn = [&]( const Pixel & pixel )
-    {
-        destinationPixelWriter.putPixelLn( pixel );
-    };
-
-    unsigned width = Abs( fmt.w );
-    unsigned height = Abs( fmt.h );
+        orient( srcFmt, source, fmt, destination, false, false, transpose );
+        return;
+    }
 
     auto id = fmt.id( 'A' );
+    makeException( id );
 
-    std::vector<std::vector<Pixel>> image( height, std::vector<Pixel>( width ) );
-    for( unsigned y = 0; y < height; ++y )
-    {
-        for( unsigned x = 0; x < width; ++x )
-        {
-            auto &pixel = image[y][x];
-            getPixelLn( pixel );
+    // Transparency is added into destination, unless axes are swapped afterwards
+    auto keyedFmt = fmt;
+    keyedFmt.compression.clear();
+    keyedFmt.w = srcFmt.w;
+    keyedFmt.h = srcFmt.h;
 
-            if( transparent )
-            {
-                makeException( id );
-                auto position = pixel.begin();
-                position += *id;
-                pixel.insert( position, pixel == *transparent ? 0 : fmt.channels[*id].max() );
-            }
-        }
+    Reference keyed;
+    if( transpose )
+    {
+        keyed.fill();
+        sync( keyedFmt, keyed );
     }
 
-    for( unsigned y = 0; y < height; ++y )
+    PixelReader sourcePixelReader( srcFmt, source );
+    PixelWriter keyedPixelWriter( keyedFmt, transpose ? keyed : destination );
+
+    Pixel pixel;
+    auto alpha = fmt.channels[*id].max();
+    for( size_t i = sizeProduct( Abs( srcFmt.w ), Abs( srcFmt.h ) ); i > 0; --i )
     {
-        for( unsigned x = 0; x < width; ++x )
-        {
-            putPixelLn( image[y][x] );
-        }
+        makeException( sourcePixelReader.getPixelLn( pixel ) );
+        auto position = pixel.begin();
+        position += *id;
+        pixel.insert( position, pixel == *transparent ? 0 : alpha );
+        makeException( keyedPixelWriter.putPixelLn( pixel ) );
     }
+
+    if( transpose )
+        orient( keyedFmt, keyed, fmt, destination, false, false, true );
 }
 
 bool Misc::equals( const Compression &other ) const
@@ -177,6 +338,7 @@ bool Misc::equals( const Compression &other ) const
         return this->Compression::operator==( other ) &&
                fixX == misc->fixX &&
                fixY == misc->fixY &&
+               transpose == misc->transpose &&
                transparent == misc->transparent;
     return false;
 };
@@ -200,9 +362,7 @@ void Palette::decompress( Format &fmt, const Reference &source, Reference &desti
 
     PixelWriter destinationPixelWriter( fmt, destination );
 
-    unsigned width = Abs( fmt.w );
-    unsigned height = Abs( fmt.h );
-    unsigned area = width * height;
+    size_t area = sizeProduct( Abs( fmt.w ), Abs( fmt.h ) );
 
     Pixel pixel;
     while( area > 0 )
@@ -216,7 +376,7 @@ void Palette::decompress( Format &fmt, const Reference &source, Reference &desti
     }
 }
 
-Palette::Palette( unsigned s, const PixelFormat &pfmt ) : Compression( s, pfmt )
+Palette::Palette( size_t s, const PixelFormat &pfmt ) : Compression( s, pfmt )
 {}
 
 bool Palette::equals( const Compression &other ) const
@@ -13,7 +13,7 @@ namespace ImageConvert
 {
 using HeaderWriter = std::function<void( const Format &, Reference & )>;
 
-void sync( unsigned bytes, const Format &dstFmt, Reference &destination );
+void sync( size_t bytes, const Format &dstFmt, Reference &destination );
 void sync( const Format &dstFmt, Reference &destination );
 
 struct Misc : public Compression
@@ -23,7 +23,10 @@ struct Misc : public Compression
 
     bool fixX, fixY;
 
-    Misc( unsigned s, bool x, bool y, std::optional<Pixel> t, const PixelFormat &pfmt );
+    // Axes are swapped before mirroring, so rotations by 90 and 270 degrees are possible
+    bool transpose;
+
+    Misc( size_t s, bool x, bool y, std::optional<Pixel> t, const PixelFormat &pfmt, bool r = false );
 
     void compress( Format &fmt, const Reference &source, Reference &destination ) override;
     void decompress( Format &fmt, const Reference &source, Reference &destination ) const override;
@@ -35,7 +38,7 @@ struct Palette : public Compression
 {
     std::vector<Pixel> samples;
 
-    Palette( unsigned s, const PixelFormat &pfmt );
+    Palette( size_t s, const PixelFormat &pfmt );
 
     void compress( Format &fmt, const Reference &source, Reference &destination ) override;
     void decompress( Format &fmt, const Reference &source, Reference &destination ) const override;
@@ -1,6 +1,7 @@
 #include "Image/BMP.h"
 
 #include <algorithm>
+#include <limits>
 
 #include "Image/PixelIO.h"
 #include "Basic.h"
@@ -135,112 +136,299 @@ struct BITMAPV5HEADER
 
 #pragma pack(pop)
 
-RleBmp::RleBmp( unsigned s, const PixelFormat &pfmt, unsigned g ): Compression( s, pfmt ), granule( g )
+RleBmp::RleBmp( size_t s, const PixelFormat &pfmt, unsigned g ): Compression( s, pfmt ), granule( g )
 {}
 
-void RleBmp::compress( Format &, const Reference &, Reference & )
+// Number of equal bytes at the start of both arrays, compares 8 bytes at once
+static inline unsigned matchLength( const uint8_t *a, const uint8_t *b, unsigned limit )
 {
-    // Not implemented
-    makeException( false );
+    unsigned length = 0;
+    while( length + sizeof( uint64_t ) <= limit )
+    {
+        uint64_t wordA, wordB;
+        copy( &wordA, a + length, sizeof( wordA ) );
+        copy( &wordB, b + length, sizeof( wordB ) );
+        if( wordA != wordB )
+            break;
+        length += sizeof( uint64_t );
+    }
+
+    while( length < limit && a[length] == b[length] )
+        ++length;
+    return length;
+}
+
+void RleBmp::compress( Format &fmt, const Reference &source, Reference &destination )
+{
+    makeException( ( granule == 4 || granule == 8 ) && fmt.bits == granule );
+    makeException( fmt.compression.front().get() == this );
+
+    unsigned width = Abs( fmt.w );
+    unsigned height = Abs( fmt.h );
+    size_t stride = fmt.lineSize();
+    makeException( source.bytes >= fmt.offset + height * stride );
+
+    auto sourceData = ( const uint8_t * )source.link + fmt.offset;
+
+    copy( fmt );
+    fmt.offset = 0;
+    fmt.clear();
+
+    // Encoded run takes 2 bytes, runs shorter than this are cheaper inside absolute blocks
+    unsigned breakRun = granule == 8 ? 3 : 6;
+
+    std::vector<uint8_t> encoded;
+    std::vector<uint8_t> line( width );
+    for( unsigned y = 0; y < height; ++y )
+    {
+        auto row = sourceData + y * stride;
+        if( granule == 8 )
+        {
+            ::copy( line.data(), row, width );
+        }
+        else
+        {
+            for( unsigned x = 0; x < width; ++x )
+                line[x] = x % 2 ? row[x / 2] & 0x0F : row[x / 2] >> 4;
+        }
+
+        auto p = line.data();
+
+        // Trailing zeros are left to end of line
+        unsigned end = width;
+        while( end > 0 && p[end - 1] == 0 )
+            --end;
+
+        // Pixels from 'i', that encoded run can repeat, in RLE4 it alternates two pixels
+        auto run = [&]( unsigned i )
+        {
+            unsigned limit = Min( end - i, 255u );
+            unsigned period = granule == 8 ? 1 : 2;
+            if( limit <= period )
+                return limit;
+            return period + matchLength( p + i + period, p + i, limit - period );
+        };
+
+        auto putRun = [&]( unsigned i, unsigned count )
+        {
+            encoded.push_back( count );
+            encoded.push_back( granule == 8 ? p[i] : ( p[i] << 4 ) | ( count > 1 ? p[i + 1] : 0 ) );
+        };
+
+        unsigned i = 0;
+        while( i < end )
+        {
+            auto length = run( i );
+            if( length >= breakRun )
+            {
+                putRun( i, length );
+                i += length;
+                continue;
+            }
+
+            // Absolute block lasts until a long run starts
+            unsigned j = i;
+            while( j < end && j - i < 255 )
+            {
+                length = run( j );
+                if( length >= breakRun )
+                    break;
+                j = Min( j + length, i + 255 );
+            }
+
+            // Absolute mode needs at least 3 pixels
+            if( j - i < 3 )
+            {
+                while( i < j )
+                {
+                    length = Min( run( i ), j - i );
+                    putRun( i, length );
+                    i += length;
+                }
+                continue;
+            }
+
+            encoded.push_back( 0 );
+            encoded.push_back( j - i );
+            if( granule == 8 )
+            {
+                encoded.insert( encoded.end(), p + i, p + j );
+            }
+            else
+            {
+                for( unsigned k = i; k < j; k += 2 )
+                    encoded.push_back( ( p[k] << 4 ) | ( k + 1 < j ? p[k + 1] : 0 ) );
+            }
+
+            // Blocks are aligned to 16 bits
+            if( encoded.size() % 2 )
+                encoded.push_back( 0 );
+            i = j;
+        }
+
+        // End of line or end of bitmap
+        encoded.push_back( 0 );
+        encoded.push_back( y + 1 < height ? 0 : 1 );
+    }
+
+    if( height == 0 )
+    {
+        encoded.push_back( 0 );
+        encoded.push_back( 1 );
+    }
+
+    size = encoded.size();
+    sync( fmt, destination );
+
+    ::copy( destination.link, encoded.data(), size );
 }
 
 void RleBmp::decompress( Format &fmt, const Reference &source, Reference &destination ) const
 {
-    makeException( 8 % granule == 0 && fmt.bits == granule );
+    makeException( ( granule == 4 || granule == 8 ) && fmt.bits == granule );
     makeException( fmt.compression.front().get() == this );
+    makeException( source.bytes >= fmt.offset );
 
-    PixelReader sourcePixelReader( fmt, source );
+    auto p = ( const uint8_t * )source.link + fmt.offset;
+    auto end = ( const uint8_t * )source.link + source.bytes;
 
     fmt.offset = 0;
     fmt.compression.pop_front();
     fmt.copy( *this );
     sync( fmt, destination );
 
-    PixelWriter destinationPixelWriter( fmt, destination );
+    // Skipped pixels stay zero
+    ::clear( destination.link, destination.bytes );
 
-    BitList count, command;
+    unsigned width = Abs( fmt.w );
+    unsigned height = Abs( fmt.h );
+    size_t stride = fmt.lineSize();
+    auto data = ( uint8_t * )destination.link;
+    unsigned x = 0, y = 0;
 
-    auto read = [&]( unsigned b, BitList & c )
+    auto read = [&]( unsigned bytes )
     {
-        makeException( sourcePixelReader.read( b, c ) );
+        makeException( bytes <= ( size_t )( end - p ) );
+        auto result = p;
+        p += bytes;
+        return result;
     };
 
-    auto getPixel = [&]( Pixel & pixel )
+    auto setNibble = [&]( uint8_t *row, unsigned position, uint8_t value )
     {
-        makeException( sourcePixelReader.getPixel( pixel ) );
+        auto &byte = row[position / 2];
+        byte = position % 2 ? ( byte & 0xF0 ) | value : ( byte & 0x0F ) | ( value << 4 );
     };
 
-    auto putPixelLn = [&]( const Pixel & pixel )
+    // Calls 'put( row, count, done )' for pieces of 'count' pixels
+    // Lines are continued on the next one like PixelWriter::putPixelLn does
+    auto place = [&]( unsigned count, const std::function<void( uint8_t *row, unsigned number, unsigned done )> &put )
     {
-        makeException( destinationPixelWriter.putPixelLn( pixel ) );
+        unsigned done = 0;
+        while( done < count )
+        {
+            if( x >= width )
+            {
+                x = 0;
+                ++y;
+            }
+            makeException( y < height );
+
+            auto number = Min( count - done, width - x );
+            put( data + y * stride, number, done );
+            x += number;
+            done += number;
+        }
     };
 
-    do
+    while( true )
     {
-        read( 8, count );
+        auto pair = read( 2 );
+        unsigned count = pair[0];
+        unsigned command = pair[1];
 
         // Encoded run
         if( count > 0 )
         {
-            std::vector<Pixel> pixels( 8 / granule );
-            for( auto &pixel :  pixels )
-                getPixel( pixel );
-
-            size_t i = 0;
-            while( count > 0 )
+            uint8_t value = command;
+            if( granule == 8 )
             {
-                putPixelLn( pixels[i] );
-                i = ( i + 1 ) % pixels.size();
-                --count;
+                place( count, [&]( uint8_t * row, unsigned number, unsigned )
+                {
+                    ::clear( row + x, value, number );
+                } );
+                continue;
             }
-        }
-        // Command
-        else
-        {
-            read( 8, command );
 
-            // Literal run
-            if( command > 2 )
+            place( count, [&]( uint8_t * row, unsigned number, unsigned done )
             {
-                Pixel pixel;
-                count = command;
-                unsigned pad = 16 * ( ( count * granule + 15 ) / 16 ) - count * granule;
-
-                while( count > 0 )
+                // Byte, whose nibbles are in the same order as in this row
+                uint8_t sample = ( x ^ done ) % 2 ? ( value << 4 ) | ( value >> 4 ) : value;
+                unsigned position = x;
+                if( position % 2 && number > 0 )
                 {
-                    getPixel( pixel );
-                    putPixelLn( pixel );
-                    --count;
+                    setNibble( row, position++, sample & 0x0F );
+                    --number;
                 }
+                ::clear( row + position / 2, sample, number / 2 );
+                if( number % 2 )
+                    setNibble( row, position + number - 1, sample >> 4 );
+            } );
+            continue;
+        }
 
-                BitList padding;
-                read( pad, padding );
+        // Absolute block
+        if( command > 2 )
+        {
+            unsigned bytes = ( command * granule + 7 ) / 8;
+            auto block = read( bytes + bytes % 2 );
+
+            if( granule == 8 )
+            {
+                place( command, [&]( uint8_t * row, unsigned number, unsigned done )
+                {
+                    ::copy( row + x, block + done, number );
+                } );
+                continue;
             }
 
-            switch( command )
+            place( command, [&]( uint8_t * row, unsigned number, unsigned done )
             {
-            case 0:
-                // End of line
-                destinationPixelWriter.nextLine();
-                break;
-            case 1:
-                // End of bitmap
-                break;
-            case 2:
-                // Delta
+                if( x % 2 == 0 && done % 2 == 0 )
                 {
-                    BitList dx, dy;
-                    read( 8, dx );
-                    read( 8, dy );
-                    destinationPixelWriter.add( dx, dy );
+                    ::copy( row + x / 2, block + done / 2, number / 2 );
+                    if( number % 2 )
+                        setNibble( row, x + number - 1, block[( done + number - 1 ) / 2] >> 4 );
+                    return;
                 }
-                break;
-            default:
-                break;
-            }
+
+                for( unsigned k = 0; k < number; ++k )
+                {
+                    auto nibble = block[( done + k ) / 2];
+                    setNibble( row, x + k, ( done + k ) % 2 ? nibble & 0x0F : nibble >> 4 );
+                }
+            } );
+            continue;
         }
+
+        // End of line
+        if( command == 0 )
+        {
+            x = 0;
+            ++y;
+            continue;
+        }
+
+        // End of bitmap
+        if( command == 1 )
+            break;
+
+        // Delta
+        auto delta = read( 2 );
+        x += delta[0];
+        y += delta[1];
+        makeException( x <= width && y < height );
     }
-    while( command != 1 );
 }
 
 bool RleBmp::equals( const Compression &other ) const
@@ -332,7 +520,7 @@ static void extractBmp( Format &fmt, const void *palettePtr, unsigned colorNumbe
     makeException( false );
 }
 
-static void extractBmp( Format &fmt, unsigned bytes, const BITMAPCOREHEADER *h )
+static void extractBmp( Format &fmt, size_t bytes, const BITMAPCOREHEADER *h )
 {
     fmt.offset += h->bcSize;
     fmt.bits = h->bcBitCount;
@@ -342,10 +530,10 @@ static void extractBmp( Format &fmt, unsigned bytes, const BITMAPCOREHEADER *h )
 
     makeException( fmt.offset <= bytes );
 
-    unsigned restBytes = fmt.bufferSize();
+    size_t restBytes = fmt.bufferSize();
     makeException( restBytes <= bytes );
 
-    unsigned paletteBytes = bytes - restBytes;
+    size_t paletteBytes = bytes - restBytes;
     unsigned colorNumber = paletteBytes / 3;
 
     // It seems, they have padding in there
@@ -414,7 +602,7 @@ static inline std::vector<Channel> extractBmpChannels( const uint32_t *masks, in
 }
 
 // Count the number of masks within header itself, if masks are outside header, use nullptr for masks
-static void extractBmp( Format &fmt, unsigned bytes, const BITMAPINFOHEADER *header, int numMasks, const uint32_t *masks, bool reserved, bool alpha )
+static void extractBmp( Format &fmt, size_t bytes, const BITMAPINFOHEADER *header, int numMasks, const uint32_t *masks, bool reserved, bool alpha )
 {
     BITMAPINFOHEADER h;
     copy( &h, header, sizeof( h ) );
@@ -480,7 +668,7 @@ static void extractBmp( Format &fmt, unsigned bytes, const BITMAPINFOHEADER *hea
     makeException( false );
 }
 
-static void extractBmp( Format &fmt, const void *data, unsigned bytes )
+static void extractBmp( Format &fmt, const void *data, size_t bytes )
 {
     uint32_t size;
     makeException( fmt.offset + sizeof( size ) <= bytes );
@@ -588,6 +776,9 @@ void makeBmp( const Reference &ref, bool fileHeader, bool bmpHeader, Format &for
 
         if( fileHeader )
         {
+            // File header stores size in 32 bits
+            makeException( reference.bytes <= std::numeric_limits<uint32_t>::max() );
+
             BITMAPFILEHEADER fh;
             fh.bfType = 0x4D42;
             fh.bfSize = reference.bytes;
@@ -15,7 +15,7 @@ struct RleBmp : public Compression
 {
     unsigned granule = 0;
 
-    RleBmp( unsigned s, const PixelFormat &pfmt, unsigned g );
+    RleBmp( size_t s, const PixelFormat &pfmt, unsigned g );
 
     void compress( Format &fmt, const Reference &source, Reference &destination ) override;
     void decompress( Format &fmt, const Reference &source, Reference &destination ) const override;
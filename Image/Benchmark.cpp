@@ -0,0 +1,231 @@
+#include "Image/Benchmark.h"
+
+#include <cstdint>
+#include <chrono>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#include "Image/Translate.h"
+#include "Image/Format.h"
+
+#include "RandomNumber.h"
+#include "Exception.h"
+#include "Basic.h"
+
+namespace ImageConvert
+{
+static long long unsigned peakResidentBytes()
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if( GetProcessMemoryInfo( GetCurrentProcess(), &counters, sizeof( counters ) ) )
+        return counters.PeakWorkingSetSize;
+    return 0;
+#else
+    rusage usage;
+    if( getrusage( RUSAGE_SELF, &usage ) == 0 )
+        return ( long long unsigned )usage.ru_maxrss * 1024;
+    return 0;
+#endif
+}
+
+Reference synthesize( const std::string &content, int w, int h )
+{
+    makeException( w > 0 && h > 0 );
+
+    Reference image;
+    image.fill();
+    image.format = "R8G8B8A8";
+    image.w = w;
+    image.h = h;
+    size_t pixels = sizeProduct( w, h );
+    image.bytes = sizeProduct( pixels, 4 );
+    makeException( image.reset( image ) );
+
+    auto pixel = ( uint8_t * )image.link;
+    auto put = [&]( unsigned r, unsigned g, unsigned b, unsigned a )
+    {
+        *pixel++ = r;
+        *pixel++ = g;
+        *pixel++ = b;
+        *pixel++ = a;
+    };
+
+    if( content == "noise" )
+    {
+        RandomNumber random;
+        for( size_t i = 0; i < pixels; ++i )
+            put( random.getInteger( 0, 255 ), random.getInteger( 0, 255 ), random.getInteger( 0, 255 ), random.getInteger( 0, 255 ) );
+        return image;
+    }
+
+    if( content == "gradient" )
+    {
+        for( int y = 0; y < h; ++y )
+        {
+            for( int x = 0; x < w; ++x )
+                put( 255ll * x / w, 255ll * y / h, 255ll * ( x + y ) / ( ( long long )w + h ), 255 - 128ll * x / w );
+        }
+        return image;
+    }
+
+    if( content == "screenshot" )
+    {
+        // Windows of flat colors with borders, title bars and lines of "text"
+        RandomNumber random;
+        std::vector<int> windows;
+        for( int i = 0; i < 8; ++i )
+        {
+            int x0 = random.getInteger( 0, w - 1 ), y0 = random.getInteger( 0, h - 1 );
+            int x1 = ( int )Min( ( long long )w, x0 + random.getInteger( w / 8, w / 2 ) );
+            int y1 = ( int )Min( ( long long )h, y0 + random.getInteger( h / 8, h / 2 ) );
+            windows.insert( windows.end(), { x0, y0, x1, y1 } );
+        }
+
+        for( int y = 0; y < h; ++y )
+        {
+            for( int x = 0; x < w; ++x )
+            {
+                unsigned r = 32, g = 96, b = 160;
+                for( size_t i = 0; i < windows.size(); i += 4 )
+                {
+                    int x0 = windows[i], y0 = windows[i + 1], x1 = windows[i + 2], y1 = windows[i + 3];
+                    if( x < x0 || x >= x1 || y < y0 || y >= y1 )
+                        continue;
+
+                    if( x == x0 || x == x1 - 1 || y == y0 || y == y1 - 1 )
+                        r = g = b = 64;
+                    else if( y < y0 + 20 )
+                        r = 200, g = 210, b = 230;
+                    else if( ( y - y0 ) % 16 < 10 && ( x * 7ll + ( y - y0 ) / 16 * 13ll ) % 23 < 15 && ( ( x / 3 ) ^ ( y / 2 ) ) % 3 )
+                        r = g = b = 20;
+                    else
+                        r = g = b = 250;
+                }
+                put( r, g, b, 255 );
+            }
+        }
+        return image;
+    }
+
+    makeException( false );
+    return image;
+}
+
+template<typename F>
+static double measure( unsigned repeat, F function )
+{
+    double best = std::numeric_limits<double>::max();
+    for( unsigned i = 0; i < Max( repeat, 1u ); ++i )
+    {
+        auto start = std::chrono::steady_clock::now();
+        function();
+        std::chrono::duration<double> seconds = std::chrono::steady_clock::now() - start;
+        best = Min( best, seconds.count() );
+    }
+    return best;
+}
+
+static void report( Information::Item &results, const std::string &path, const std::string &image, const char *operation,
+                    const Reference &decoded, const Reference &encoded, double seconds )
+{
+    auto widen = []( const std::string & string )
+    {
+        return std::wstring( string.begin(), string.end() );
+    };
+
+    double pixels = double( Abs( decoded.w ) ) * Abs( decoded.h );
+    seconds = Max( seconds, 1e-9 );
+
+    Information::Item item;
+    item = Information::Object();
+    item( L"path" ) = widen( path );
+    item( L"image" ) = widen( image );
+    item( L"operation" ) = widen( operation );
+    item( L"width" ) = Abs( decoded.w );
+    item( L"height" ) = Abs( decoded.h );
+    item( L"encodedBytes" ) = encoded.bytes;
+    item( L"seconds" ) = seconds;
+    item( L"megapixelsPerSecond" ) = pixels / seconds / 1e6;
+    item( L"megabytesPerSecond" ) = 4 * pixels / seconds / 1e6;
+    item( L"peakResidentBytes" ) = peakResidentBytes();
+
+    results.as<Information::Array>().push( std::move( item ) );
+}
+
+void Benchmark::run( Information::Item &results ) const
+{
+    if( !results.is<Information::Array>() )
+        results = Information::Array();
+
+    // Channels, that are missing in source, are filled, so every path can be decoded to the same format
+    // Greyscale files have only G channel, it is copied to R and B
+    const std::string decodedFormat = "R8G8B8A8*REPRG*REPBG*REPA255";
+    const std::string deepDecodedFormat = "R16G16B16A16*REPRG*REPBG*REPA65535";
+
+    auto path = [&]( const Reference &source, const std::string &format, const std::string &decodedAs, const std::string &name, const std::string &image )
+    {
+        Reference encoded, decoded;
+        encoded.fill();
+        decoded.fill();
+
+        auto seconds = measure( repeat, [&]()
+        {
+            encoded.format = format;
+            translate( source, encoded, false );
+        } );
+        report( results, name, image, "encode", source, encoded, seconds );
+
+        seconds = measure( repeat, [&]()
+        {
+            decoded.format = decodedAs;
+            translate( encoded, decoded, false );
+        } );
+        report( results, name, image, "decode", decoded, encoded, seconds );
+    };
+
+    for( auto [w, h] : sizes )
+    {
+        for( const auto &content : contents )
+        {
+            auto source = synthesize( content, w, h );
+            auto image = content + " " + std::to_string( w ) + "x" + std::to_string( h );
+
+            for( const auto &format : formats )
+                path( source, format, decodedFormat, format, image );
+
+            if( deepFormats.empty() )
+                continue;
+
+            // Wide copy of 8-bit image, writers choose 16-bit channels by depth of source
+            Reference deep;
+            deep.fill();
+            deep.format = "R16G16B16A16";
+            translate( source, deep, false );
+
+            for( const auto &format : deepFormats )
+                path( deep, format, deepDecodedFormat, format + " 16-bit", image );
+        }
+    }
+
+    for( const auto &[name, file] : files )
+    {
+        makeException( file );
+
+        Reference decoded;
+        decoded.fill();
+
+        auto seconds = measure( repeat, [&]()
+        {
+            decoded.format = decodedFormat;
+            translate( *file, decoded, false );
+        } );
+        report( results, file->format.value_or( "" ), name, "decode", decoded, *file, seconds );
+    }
+}
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <utility>
+#include <vector>
+#include <string>
+
+#include "Image/Reference.h"
+
+#include "Information.h"
+
+namespace ImageConvert
+{
+// Creates R8G8B8A8 image of given content, same arguments always produce same image
+// Contents:
+// 'noise' random values in every channel, worst case for compression
+// 'gradient' smooth ramps, typical for photos and renders
+// 'screenshot' flat rectangles with sharp edges and text-like stripes
+Reference synthesize( const std::string &content, int w, int h );
+
+// Measures throughput of 'translate' for every path
+// Each synthetic image is encoded into every format from 'formats' and decoded back as R8G8B8A8
+// Its R16G16B16A16 copy is encoded into every format from 'deepFormats' and decoded back as R16G16B16A16
+// Each of 'files' is only decoded, use it for paths, that can't be written (JPEG or palette PNG)
+struct Benchmark
+{
+    std::vector<std::pair<int, int>> sizes { {256, 256}, {1920, 1080} };
+    std::vector<std::string> contents { "noise", "gradient", "screenshot" };
+    std::vector<std::string> formats { ".DIB", ".BMP", ".PNG", ".QOI", "R8G8B8A8", "B5G6R5", "R16G16B16A16" };
+
+    // Formats, that keep 16-bit channels of source, their paths are reported as "<format> 16-bit"
+    std::vector<std::string> deepFormats { ".PNG" };
+
+    // Names and encoded images, formats of references should be set, for example to '.ANYF'
+    std::vector<std::pair<std::string, const Reference *>> files;
+
+    // Every measurement is repeated, best time is reported
+    unsigned repeat = 3;
+
+    // Appends an object to array 'results' for every measurement:
+    // path, image, operation ('encode' or 'decode'), width, height, encodedBytes, seconds
+    // megapixelsPerSecond, megabytesPerSecond (uncompressed R8G8B8A8 bytes per second)
+    // peakResidentBytes (peak memory of process, so far, it never decreases between measurements)
+    // 'results' can be saved with Information::Item::output to compare builds
+    void run( Information::Item &results ) const;
+};
+}
@@ -0,0 +1,74 @@
+// Program, that runs Benchmark, prints throughput and saves results
+// It is compiled only with IMAGE_BENCHMARK_MAIN defined, so projects, that use Image as library, don't get second 'main'
+// Build it together with sources of Image and utilities, they use, for example:
+// g++ -std=c++17 -O2 -DIMAGE_BENCHMARK_MAIN -I. Image/*.cpp Parallel.cpp RandomNumber.cpp Information.cpp ... -lz -o benchmark
+// Usage: benchmark [results.json] [encoded files, that are only decoded...]
+#ifdef IMAGE_BENCHMARK_MAIN
+
+#include <iterator>
+#include <fstream>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+#include <string>
+#include <list>
+
+#include "Image/Benchmark.h"
+
+#include "Exception.h"
+
+using namespace ImageConvert;
+
+int main( int argc, char **argv )
+{
+    try
+    {
+        Benchmark benchmark;
+
+        // Contents of files must live as long as references to them
+        std::list<std::vector<uint8_t>> contents;
+        std::list<Reference> files;
+        for( int i = 2; i < argc; ++i )
+        {
+            std::ifstream file( argv[i], std::ios::binary );
+            makeException( file.is_open() );
+            auto &content = contents.emplace_back( std::istreambuf_iterator<char>( file ), std::istreambuf_iterator<char>() );
+
+            auto &reference = files.emplace_back();
+            reference.format = ".ANYF";
+            reference.link = content.data();
+            reference.bytes = content.size();
+            benchmark.files.emplace_back( argv[i], &reference );
+        }
+
+        Information::Item results;
+        benchmark.run( results );
+
+        std::printf( "%-16s %-24s %-8s %12s %12s\n", "path", "image", "op", "MPixel/s", "MB/s" );
+        for( const auto &item : results.as<Information::Array>() )
+        {
+            auto narrow = []( const std::wstring & string )
+            {
+                return std::string( string.begin(), string.end() );
+            };
+
+            std::printf( "%-16s %-24s %-8s %12.1f %12.1f\n",
+                         narrow( item( L"path" ).as<Information::String>() ).c_str(),
+                         narrow( item( L"image" ).as<Information::String>() ).c_str(),
+                         narrow( item( L"operation" ).as<Information::String>() ).c_str(),
+                         double( item( L"megapixelsPerSecond" ).as<long double>() ),
+                         double( item( L"megabytesPerSecond" ).as<long double>() ) );
+        }
+
+        if( argc > 1 )
+            makeException( results.output( argv[1] ) );
+    }
+    catch( const Exception &e )
+    {
+        std::fwprintf( stderr, L"%ls\n", e.message().c_str() );
+        return 1;
+    }
+    return 0;
+}
+
+#endif
@@ -0,0 +1,227 @@
+#include "Image/Cache.h"
+
+#include <cstring>
+
+#include "Image/Translate.h"
+
+#include "Exception.h"
+
+namespace ImageConvert
+{
+static constexpr uint64_t prime1 = 0x9E3779B185EBCA87ull;
+static constexpr uint64_t prime2 = 0xC2B2AE3D27D4EB4Full;
+static constexpr uint64_t prime3 = 0x165667B19E3779F9ull;
+static constexpr uint64_t prime4 = 0x85EBCA77C2B2AE63ull;
+static constexpr uint64_t prime5 = 0x27D4EB2F165667C5ull;
+
+static inline uint64_t rotate( uint64_t x, int r )
+{
+    return ( x << r ) | ( x >> ( 64 - r ) );
+}
+
+// Little-endian loads, as xxHash defines them
+static inline uint64_t load64( const uint8_t *p )
+{
+    uint64_t x;
+    std::memcpy( &x, p, sizeof( x ) );
+    return x;
+}
+
+static inline uint32_t load32( const uint8_t *p )
+{
+    uint32_t x;
+    std::memcpy( &x, p, sizeof( x ) );
+    return x;
+}
+
+static inline uint64_t accumulate( uint64_t accumulator, uint64_t input )
+{
+    return rotate( accumulator + input * prime2, 31 ) * prime1;
+}
+
+static inline uint64_t merge( uint64_t accumulator, uint64_t value )
+{
+    return ( accumulator ^ accumulate( 0, value ) ) * prime1 + prime4;
+}
+
+uint64_t hash64( const void *data, size_t bytes, uint64_t seed )
+{
+    auto p = ( const uint8_t * )data;
+    auto end = p + bytes;
+    uint64_t h;
+
+    if( bytes >= 32 )
+    {
+        // Four independent lanes, so loads and multiplications overlap
+        uint64_t v1 = seed + prime1 + prime2, v2 = seed + prime2, v3 = seed, v4 = seed - prime1;
+        for( ; end - p >= 32; p += 32 )
+        {
+            v1 = accumulate( v1, load64( p ) );
+            v2 = accumulate( v2, load64( p + 8 ) );
+            v3 = accumulate( v3, load64( p + 16 ) );
+            v4 = accumulate( v4, load64( p + 24 ) );
+        }
+
+        h = rotate( v1, 1 ) + rotate( v2, 7 ) + rotate( v3, 12 ) + rotate( v4, 18 );
+        h = merge( h, v1 );
+        h = merge( h, v2 );
+        h = merge( h, v3 );
+        h = merge( h, v4 );
+    }
+    else
+    {
+        h = seed + prime5;
+    }
+
+    h += bytes;
+
+    for( ; end - p >= 8; p += 8 )
+        h = rotate( h ^ accumulate( 0, load64( p ) ), 27 ) * prime1 + prime4;
+
+    if( end - p >= 4 )
+    {
+        h = rotate( h ^ ( load32( p ) * prime1 ), 23 ) * prime2 + prime3;
+        p += 4;
+    }
+
+    for( ; p < end; ++p )
+        h = rotate( h ^ ( *p * prime5 ), 11 ) * prime1;
+
+    h ^= h >> 33;
+    h *= prime2;
+    h ^= h >> 29;
+    h *= prime3;
+    h ^= h >> 32;
+    return h;
+}
+
+bool TranslateCache::Key::operator==( const Key &other ) const
+{
+    return
+        hash == other.hash && bytes == other.bytes &&
+        srcW == other.srcW && srcH == other.srcH && dstW == other.dstW && dstH == other.dstH &&
+        scale == other.scale && srcFormat == other.srcFormat && dstFormat == other.dstFormat;
+}
+
+size_t TranslateCache::KeyHash::operator()( const Key &key ) const
+{
+    return key.hash;
+}
+
+TranslateCache::TranslateCache( size_t c ) : capacity( c )
+{}
+
+TranslateCache::~TranslateCache()
+{}
+
+void TranslateCache::translate( const Reference &source, Reference &destination, bool scale )
+{
+    makeException( source.format.has_value() && source.link );
+
+    Key key;
+    key.bytes = source.bytes;
+    key.srcFormat = *source.format;
+    key.dstFormat = destination.format.value_or( *source.format );
+    key.srcW = source.w;
+    key.srcH = source.h;
+    key.dstW = destination.w;
+    key.dstH = destination.h;
+    key.scale = scale;
+
+    // Everything except the content is compared exactly, so it's only mixed into seed
+    uint64_t seed = hash64( key.srcFormat.data(), key.srcFormat.size(), hash64( key.dstFormat.data(), key.dstFormat.size() ) );
+    key.hash = hash64( source.link, source.bytes, seed ^ ( uint64_t( uint32_t( key.dstW ) ) << 32 | uint32_t( key.dstH ) ) );
+
+    std::shared_ptr<Reference> result;
+
+    {
+        std::lock_guard<std::mutex> lock( mutex );
+        auto found = entries.find( key );
+        if( found != entries.end() )
+        {
+            ++counters.hits;
+            order.splice( order.begin(), order, found->second );
+            result = found->second->second;
+        }
+        else
+        {
+            ++counters.misses;
+        }
+    }
+
+    if( !result )
+    {
+        // Translation runs without the lock, other threads can use the cache meanwhile
+        result = std::make_shared<Reference>();
+        result->fill();
+        result->format = key.dstFormat;
+        result->w = key.dstW;
+        result->h = key.dstH;
+        ImageConvert::translate( source, *result, scale );
+
+        std::lock_guard<std::mutex> lock( mutex );
+        auto found = entries.find( key );
+        if( found != entries.end() )
+        {
+            // Another thread has translated the same image first, share its result
+            order.splice( order.begin(), order, found->second );
+            result = found->second->second;
+        }
+        else if( result->bytes <= capacity )
+        {
+            order.emplace_front( key, result );
+            entries.emplace( std::move( key ), order.begin() );
+            counters.bytes += result->bytes;
+            ++counters.entries;
+            evict();
+        }
+    }
+
+    Reference view;
+    view.format = result->format;
+    view.bytes = result->bytes;
+    view.link = result->link;
+    view.w = result->w;
+    view.h = result->h;
+
+    // View owns a share of the result and releases it, when it's destroyed
+    view.clear = [result]( Reference & ) {};
+
+    destination = std::move( view );
+}
+
+TranslateCache::Statistics TranslateCache::statistics() const
+{
+    std::lock_guard<std::mutex> lock( mutex );
+    return counters;
+}
+
+void TranslateCache::resize( size_t c )
+{
+    std::lock_guard<std::mutex> lock( mutex );
+    capacity = c;
+    evict();
+}
+
+void TranslateCache::clear()
+{
+    std::lock_guard<std::mutex> lock( mutex );
+    entries.clear();
+    order.clear();
+    counters.bytes = 0;
+    counters.entries = 0;
+}
+
+void TranslateCache::evict()
+{
+    while( counters.bytes > capacity && !order.empty() )
+    {
+        auto &last = order.back();
+        counters.bytes -= last.second->bytes;
+        --counters.entries;
+        ++counters.evictions;
+        entries.erase( last.first );
+        order.pop_back();
+    }
+}
+}
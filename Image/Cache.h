@@ -0,0 +1,77 @@
+#pragma once
+
+#include <unordered_map>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <mutex>
+#include <list>
+
+#include "Image/Reference.h"
+
+namespace ImageConvert
+{
+// Remembers results of 'translate', so repeated inputs are not decoded again
+// Results are found by 64-bit hash of source bytes together with both formats, dimensions and 'scale'
+// Least recently used results are dropped, when their total size exceeds 'capacity' bytes
+// Can be used from several threads at once
+class TranslateCache
+{
+public:
+    struct Statistics
+    {
+        long long unsigned hits = 0, misses = 0, evictions = 0;
+
+        // Size and number of results, that are currently kept
+        size_t bytes = 0, entries = 0;
+    };
+
+    TranslateCache( size_t capacity );
+    ~TranslateCache();
+
+    // Same as 'translate', but 'destination' becomes a read-only view of the cached result
+    // 'format', 'w' and 'h' of 'destination' are used as 'translate' uses them, then its previous data is released
+    // View has no 'reset', it stays valid after the result is evicted or the cache is destroyed
+    // Results bigger than 'capacity' are returned, but not kept
+    void translate( const Reference &source, Reference &destination, bool scale );
+
+    Statistics statistics() const;
+
+    // Changes capacity, evicting results, that don't fit anymore
+    void resize( size_t capacity );
+
+    // Drops all results, counters are not reset
+    void clear();
+private:
+    struct Key
+    {
+        uint64_t hash;
+        size_t bytes;
+        std::string srcFormat, dstFormat;
+        int srcW, srcH, dstW, dstH;
+        bool scale;
+
+        bool operator==( const Key &other ) const;
+    };
+
+    struct KeyHash
+    {
+        size_t operator()( const Key &key ) const;
+    };
+
+    using Entry = std::pair<Key, std::shared_ptr<Reference>>;
+
+    // Front is the most recently used result
+    std::list<Entry> order;
+    std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> entries;
+
+    size_t capacity;
+    Statistics counters;
+    mutable std::mutex mutex;
+
+    void evict();
+};
+
+// Hash of 'bytes' at 'data', xxHash64 algorithm
+uint64_t hash64( const void *data, size_t bytes, uint64_t seed = 0 );
+}
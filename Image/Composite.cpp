@@ -0,0 +1,136 @@
+#include "Image/Composite.h"
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "Image/Translate.h"
+
+#include "Exception.h"
+#include "Parallel.h"
+#include "BitIO.h"
+#include "Basic.h"
+
+namespace ImageConvert
+{
+// Kernels work with interleaved RGBA lines, every lane is processed the same way, so compilers vectorize them
+// Images store 16-bit channels in big-endian order, kernels swap them while loading and storing
+template<typename T>
+struct Premultiplied
+{
+    static constexpr uint32_t max = std::numeric_limits<T>::max();
+
+    static inline T order( T x )
+    {
+        if constexpr( sizeof( T ) == 1 )
+            return x;
+        else
+            return swapBe16( x );
+    }
+
+    // Rounded x / max for x in [0, max * max], multiply-high form of (x + (x >> n) + half) >> n
+    static inline uint32_t divide( uint32_t x )
+    {
+        if constexpr( sizeof( T ) == 1 )
+            return ( ( x + 128 ) * 257 ) >> 16;
+        else
+            return uint32_t( ( uint64_t( x + 32768 ) * 65537 ) >> 32 );
+    }
+
+    // Converts straight alpha colors to premultiplied ones, alpha is multiplied by 'opacity' first
+    static void premultiply( const T *source, T *destination, size_t count, uint32_t opacity )
+    {
+        for( size_t i = 0; i < count; ++i, source += 4, destination += 4 )
+        {
+            uint32_t alpha = order( source[3] );
+            if( opacity < max )
+                alpha = divide( alpha * opacity );
+            destination[0] = divide( order( source[0] ) * alpha );
+            destination[1] = divide( order( source[1] ) * alpha );
+            destination[2] = divide( order( source[2] ) * alpha );
+            destination[3] = alpha;
+        }
+    }
+
+    // Result = top + bottom * (1 - top alpha), same formula for color and alpha lanes
+    static void over( const T *top, T *bottom, size_t count )
+    {
+        for( size_t i = 0; i < count; ++i, top += 4, bottom += 4 )
+        {
+            uint32_t inverse = max - top[3];
+            bottom[0] = top[0] + divide( bottom[0] * inverse );
+            bottom[1] = top[1] + divide( bottom[1] * inverse );
+            bottom[2] = top[2] + divide( bottom[2] * inverse );
+            bottom[3] = top[3] + divide( bottom[3] * inverse );
+        }
+    }
+
+    // Colors of opaque pixels, which are most common, stay as they are
+    static void unpremultiply( T *line, size_t count )
+    {
+        for( size_t i = 0; i < count; ++i, line += 4 )
+        {
+            uint32_t alpha = line[3];
+            for( unsigned c = 0; c < 3; ++c )
+            {
+                uint32_t color = line[c];
+                if( alpha < max )
+                    color = alpha > 0 ? Min( max, ( color * max + alpha / 2 ) / alpha ) : 0;
+                line[c] = order( color );
+            }
+            line[3] = order( alpha );
+        }
+    }
+
+    static void composite( const Reference &top, Reference &bottom, uint32_t opacity, int x, int y )
+    {
+        int x0 = Max( x, 0 ), x1 = Min( bottom.w, x + top.w );
+        int y0 = Max( y, 0 ), y1 = Min( bottom.h, y + top.h );
+        if( x0 >= x1 || y0 >= y1 )
+            return;
+
+        size_t count = x1 - x0;
+        auto topLines = ( const T * )top.link;
+        auto bottomLines = ( T * )bottom.link;
+
+        parallelFor( y1 - y0, [&]( size_t begin, size_t end )
+        {
+            std::vector<T> premultiplied( 4 * count );
+            for( size_t i = begin; i < end; ++i )
+            {
+                auto topLine = topLines + 4 * ( ( y0 + i - y ) * top.w + ( x0 - x ) );
+                auto bottomLine = bottomLines + 4 * ( ( y0 + i ) * bottom.w + x0 );
+
+                premultiply( topLine, premultiplied.data(), count, opacity );
+                premultiply( bottomLine, bottomLine, count, max );
+                over( premultiplied.data(), bottomLine, count );
+                unpremultiply( bottomLine, count );
+            }
+        }, 16 );
+    }
+};
+
+void blend( const Reference &top, const Reference &bottom, Reference &destination, double opacity, int x, int y )
+{
+    makeException( 0 <= opacity && opacity <= 1 );
+
+    bool deep = Max( channelDepth( top ), channelDepth( bottom ) ) > 8;
+
+    auto topPixels = unpackRgba( top, deep );
+    auto bottomPixels = unpackRgba( bottom, deep );
+
+    if( deep )
+        Premultiplied<uint16_t>::composite( topPixels, bottomPixels, uint32_t( opacity * 65535 + 0.5 ), x, y );
+    else
+        Premultiplied<uint8_t>::composite( topPixels, bottomPixels, uint32_t( opacity * 255 + 0.5 ), x, y );
+
+    if( !destination.format )
+        destination.format = bottom.format;
+    translate( bottomPixels, destination, false );
+}
+
+void over( const Reference &top, const Reference &bottom, Reference &destination, int x, int y )
+{
+    blend( top, bottom, destination, 1, x, y );
+}
+}
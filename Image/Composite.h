@@ -0,0 +1,15 @@
+#pragma once
+
+#include "Image/Reference.h"
+
+namespace ImageConvert
+{
+// Porter-Duff 'over': places 'top' over 'bottom' with its upper left corner at (x, y), writes result into 'destination'
+// Sources can have any formats, that 'translate' reads, parts of 'top' outside of 'bottom' are ignored
+// If 'destination' has no format, format of 'bottom' is used
+// Colors are blended with premultiplied alpha in 8 bits per channel, or in 16 bits, if any source has deeper channels
+void over( const Reference &top, const Reference &bottom, Reference &destination, int x = 0, int y = 0 );
+
+// Same as 'over', but alpha of 'top' is multiplied by 'opacity' from range [0, 1]
+void blend( const Reference &top, const Reference &bottom, Reference &destination, double opacity, int x = 0, int y = 0 );
+}
@@ -1 +1,38 @@
-#include "Image\Data.h"
+#include "Image/Data.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+namespace ImageConvert
+{
+const uint16_t *depthTable( unsigned srcBits, unsigned dstBits )
+{
+    makeException( 0 < srcBits && srcBits <= depthTableBits );
+    makeException( 0 < dstBits && dstBits <= depthTableBits );
+
+    static std::atomic<const uint16_t *> tables[depthTableBits][depthTableBits];
+    static std::unique_ptr<uint16_t[]> storage[depthTableBits][depthTableBits];
+    static std::mutex mutex;
+
+    auto &table = tables[srcBits - 1][dstBits - 1];
+    if( auto pointer = table.load( std::memory_order_acquire ) )
+        return pointer;
+
+    std::lock_guard<std::mutex> lock( mutex );
+    if( auto pointer = table.load( std::memory_order_relaxed ) )
+        return pointer;
+
+    // Products fit 32 bits, rounding matches 'rescale' for wide channels
+    uint32_t srcMax = ( 1u << srcBits ) - 1;
+    uint32_t dstMax = ( 1u << dstBits ) - 1;
+
+    auto &values = storage[srcBits - 1][dstBits - 1];
+    values = std::make_unique<uint16_t[]>( srcMax + 1 );
+    for( uint32_t x = 0; x <= srcMax; ++x )
+        values[x] = uint16_t( ( x * dstMax + srcMax / 2 ) / srcMax );
+
+    table.store( values.get(), std::memory_order_release );
+    return values.get();
+}
+}
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <vector>
 
 #include "Image/Format.h"
@@ -27,7 +28,71 @@ static inline B toFloat( A x, const Channel &c )
     return max > 0 ? B( x ) / B( max ) : B( 0 );
 }
 
+// Largest channel depth, that is converted through precomputed tables
+constexpr unsigned depthTableBits = 16;
+
+// Returns table with 2^srcBits entries, which maps values of srcBits channel to values of dstBits channel
+// Both depths must be in range [1, depthTableBits], tables are built once and shared between threads
+const uint16_t *depthTable( unsigned srcBits, unsigned dstBits );
+
+// Returns x * m / d rounded to nearest, x must not exceed d
+// Product is kept in two 64-bit halves and divided bit by bit, so no 128-bit type of compiler is needed
+static inline uint64_t mulDivRound( uint64_t x, uint64_t m, uint64_t d )
+{
+    uint64_t xl = x & 0xffffffff, xh = x >> 32, ml = m & 0xffffffff, mh = m >> 32;
+    uint64_t ll = xl * ml, lh = xl * mh, hl = xh * ml, hh = xh * mh;
+    uint64_t middle = ( ll >> 32 ) + ( lh & 0xffffffff ) + ( hl & 0xffffffff );
+    uint64_t low = ( middle << 32 ) | ( ll & 0xffffffff );
+    uint64_t high = hh + ( lh >> 32 ) + ( hl >> 32 ) + ( middle >> 32 );
+
+    uint64_t half = d / 2;
+    low += half;
+    if( low < half )
+        ++high;
+
+    // Since x <= d, high part is less than d and quotient fits into 64 bits
+    uint64_t quotient = 0, remainder = high;
+    for( int i = 63; i >= 0; --i )
+    {
+        bool carry = remainder >> 63;
+        remainder = ( remainder << 1 ) | ( ( low >> i ) & 1 );
+        quotient <<= 1;
+        if( carry || remainder >= d )
+        {
+            remainder -= d;
+            quotient |= 1;
+        }
+    }
+    return quotient;
+}
+
+// Converts integer channel value between bit depths, rounds to nearest, as normalized conversion does
+// Never touches floating point: narrow channels use tables, wide channels are rounded exactly with integer product
+static inline BitList rescale( BitList x, unsigned srcBits, unsigned dstBits )
+{
+    auto srcMax = srcBits < 64 ? ( ( ( BitList )1 ) << srcBits ) - 1 : ~( BitList )0;
+    makeException( x <= srcMax );
+
+    if( srcBits == dstBits )
+        return x;
+
+    if( srcBits <= 0 || dstBits <= 0 )
+        return 0;
+
+    if( srcBits <= depthTableBits && dstBits <= depthTableBits )
+        return depthTable( srcBits, dstBits )[x];
+
+    auto dstMax = dstBits < 64 ? ( ( ( BitList )1 ) << dstBits ) - 1 : ~( BitList )0;
+
+    // Product and rounding term fit into 64 bits, if depths sum to less than 64
+    if( srcBits + dstBits < 64 )
+        return ( x * dstMax + srcMax / 2 ) / srcMax;
+
+    return mulDivRound( x, dstMax, srcMax );
+}
+
 // Converts between integer Pixel channels and normalized double Color channels in range [0, 1]
+// Integer to integer conversions use rescale and don't go through [0, 1]
 // Matches formats channels of source and destination
 // For channels with 0 bits, the result is 0
 // If the channel is '_' its value is ignored, when read and is written as 0
@@ -44,6 +109,11 @@ static inline VB convert( const VA &src, const PixelFormat &srcFmt, const PixelF
             return a;
         }
 
+        if constexpr( !std::is_same_v<A, double> && !std::is_same_v<B, double> )
+        {
+            return B( rescale( a, cA.bits, cB.bits ) );
+        }
+
         double tmp;
         if constexpr( std::is_same_v<A, double> )
         {
@@ -1,5 +1,7 @@
 #include <Image/Format.h>
 
+#include <limits>
+
 #include "Exception.h"
 
 namespace ImageConvert
@@ -75,7 +77,19 @@ bool PixelFormat::operator==( const PixelFormat &other ) const
     return channels == other.channels;
 }
 
-Compression::Compression( unsigned s, const PixelFormat &pfmt )
+size_t sizeProduct( size_t a, size_t b )
+{
+    makeException( b == 0 || a <= std::numeric_limits<size_t>::max() / b );
+    return a * b;
+}
+
+size_t sizeSum( size_t a, size_t b )
+{
+    makeException( a <= std::numeric_limits<size_t>::max() - b );
+    return a + b;
+}
+
+Compression::Compression( size_t s, const PixelFormat &pfmt )
 {
     copy( pfmt );
     size = s;
@@ -89,21 +103,21 @@ bool Compression::equals( const Compression &other ) const
 Compression::~Compression()
 {}
 
-unsigned Format::lineSize( unsigned dbits ) const
+size_t Format::lineSize( long long unsigned dbits ) const
 {
-    unsigned bytes = ( Abs( w ) * bits + dbits + 7 ) / 8;
+    size_t bytes = sizeSum( sizeProduct( Abs( w ), bits ), sizeSum( dbits, 7 ) ) / 8;
 
     if( pad > 0 )
     {
         auto remainder = bytes % pad;
         if( remainder > 0 )
-            bytes += pad - remainder;
+            bytes = sizeSum( bytes, pad - remainder );
     }
 
     return bytes;
 }
 
-unsigned Format::bufferSize( const Compression *peelLayer ) const
+size_t Format::bufferSize( const Compression *peelLayer ) const
 {
     if( !compression.empty() )
     {
@@ -113,13 +127,13 @@ unsigned Format::bufferSize( const Compression *peelLayer ) const
             layer = compression.size() > 1 ? compression[1].get() : nullptr;
 
         if( layer )
-            return offset + layer->size;
+            return sizeSum( offset, layer->size );
     }
 
     if( pad <= 0 )
-        return offset + ( Abs( w ) * Abs( h ) * bits + 7 ) / 8;
+        return sizeSum( offset, sizeSum( sizeProduct( sizeProduct( Abs( w ), Abs( h ) ), bits ), 7 ) / 8 );
 
-    return offset + Abs( h ) * lineSize();
+    return sizeSum( offset, sizeProduct( Abs( h ), lineSize() ) );
 }
 
 bool Format::operator==( const Format &other )const
@@ -68,14 +68,18 @@ struct PixelFormat
     bool operator==( const PixelFormat &other ) const;
 };
 
+// Arithmetic of sizes, throws on overflow
+size_t sizeProduct( size_t a, size_t b );
+size_t sizeSum( size_t a, size_t b );
+
 struct Format;
 
 struct Compression : public PixelFormat
 {
     // Size of the compressed data
-    unsigned size;
+    size_t size;
 
-    Compression( unsigned s, const PixelFormat &pfmt );
+    Compression( size_t s, const PixelFormat &pfmt );
 
     virtual void compress( Format &fmt, const Reference &source, Reference &destination ) = 0;
     virtual void decompress( Format &fmt, const Reference &source, Reference &destination ) const = 0;
@@ -90,7 +94,7 @@ struct Format : public PixelFormat
     std::deque<std::shared_ptr<Compression>> compression;
 
     // Bytes of meta data before image
-    unsigned offset = 0;
+    size_t offset = 0;
 
     // Number of bytes in line should be divisible by this
     // If it's 0 padding is not used
@@ -100,10 +104,10 @@ struct Format : public PixelFormat
     int w = 0, h = 0;
 
     // Computes the number of bytes needed for a line
-    unsigned lineSize( unsigned dbits = 0 ) const;
+    size_t lineSize( long long unsigned dbits = 0 ) const;
 
     // Computes the number of bytes needed for the entire image
-    unsigned bufferSize( const Compression *peelLayer = nullptr ) const;
+    size_t bufferSize( const Compression *peelLayer = nullptr ) const;
 
     bool operator==( const Format &other )const;
 };
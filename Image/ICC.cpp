@@ -0,0 +1,445 @@
+#include "Image/ICC.h"
+
+#include <unordered_map>
+#include <optional>
+#include <array>
+#include <list>
+#include <mutex>
+#include <cmath>
+
+#include "Image/Cache.h"
+#include "Image/ANYF.h"
+
+#include "Exception.h"
+#include "Parallel.h"
+#include "Basic.h"
+
+namespace ImageConvert
+{
+// Nodes on every axis, step of 8 input levels is small enough for 8-bit results
+#define LUT_GRID 33
+
+// Bits of fractional part of position between nodes
+#define LUT_FRACTION 12
+
+// Linear value 0 is stored as LUT_ZERO and 1 as 2 * LUT_ZERO, so colors outside of sRGB gamut are clipped after interpolation
+#define LUT_ZERO 16384
+
+// Tables of this many least recently used profiles are kept, every table takes about 215 KB
+#define LUT_CACHE 8
+
+// Tone curve of 'curv' or 'para' tag, maps encoded value into linear one
+struct ToneCurve
+{
+    std::vector<double> table;
+    int function = -1;
+    double g = 1, a = 1, b = 0, c = 0, d = 0, e = 0, f = 0;
+
+    double operator()( double x ) const
+    {
+        if( !table.empty() )
+        {
+            double position = x * ( table.size() - 1 );
+            size_t i = Min( size_t( position ), table.size() - 2 );
+            return table[i] + ( table[i + 1] - table[i] ) * ( position - i );
+        }
+
+        auto power = [&]( double base )
+        {
+            return base > 0 ? std::pow( base, g ) : 0;
+        };
+
+        switch( function )
+        {
+        case 1:
+            return x >= -b / a ? power( a * x + b ) : 0;
+        case 2:
+            return x >= -b / a ? power( a * x + b ) + c : c;
+        case 3:
+            return x >= d ? power( a * x + b ) : c * x;
+        case 4:
+            return x >= d ? power( a * x + b ) + e : c * x + f;
+        default:
+            return power( x );
+        }
+    }
+};
+
+class ProfileReader
+{
+public:
+    ProfileReader( const std::vector<uint8_t> &p ) : profile( p )
+    {}
+
+    // Set, when profile is malformed, reads out of its bounds return zeros
+    mutable bool failed = false;
+
+    uint32_t u32( size_t offset ) const
+    {
+        if( !check( offset, 4 ) )
+            return 0;
+        auto p = profile.data() + offset;
+        return ( uint32_t( p[0] ) << 24 ) | ( uint32_t( p[1] ) << 16 ) | ( uint32_t( p[2] ) << 8 ) | p[3];
+    }
+
+    uint16_t u16( size_t offset ) const
+    {
+        if( !check( offset, 2 ) )
+            return 0;
+        auto p = profile.data() + offset;
+        return uint16_t( ( p[0] << 8 ) | p[1] );
+    }
+
+    double s15Fixed16( size_t offset ) const
+    {
+        return int32_t( u32( offset ) ) / 65536.0;
+    }
+
+    static constexpr uint32_t signature( const char *s )
+    {
+        return ( uint32_t( uint8_t( s[0] ) ) << 24 ) | ( uint32_t( uint8_t( s[1] ) ) << 16 ) | ( uint32_t( uint8_t( s[2] ) ) << 8 ) | uint8_t( s[3] );
+    }
+
+    // Offset of tag's data
+    std::optional<size_t> find( const char *tag ) const
+    {
+        auto count = u32( 128 );
+        if( !check( 132, 12 * size_t( count ) ) )
+            return {};
+
+        for( size_t i = 0; i < count; ++i )
+        {
+            size_t entry = 132 + 12 * i;
+            if( u32( entry ) == signature( tag ) )
+            {
+                size_t offset = u32( entry + 4 ), size = u32( entry + 8 );
+                if( size < 12 || !check( offset, size ) )
+                    return {};
+                return offset;
+            }
+        }
+        return {};
+    }
+
+    std::optional<ToneCurve> curve( const char *tag ) const
+    {
+        auto offset = find( tag );
+        if( !offset )
+            return {};
+
+        ToneCurve curve;
+        if( u32( *offset ) == signature( "curv" ) )
+        {
+            auto count = u32( *offset + 8 );
+            if( count == 1 )
+            {
+                curve.g = u16( *offset + 12 ) / 256.0;
+            }
+            else if( count > 1 )
+            {
+                if( !check( *offset + 12, 2 * size_t( count ) ) )
+                    return {};
+
+                curve.table.resize( count );
+                for( size_t i = 0; i < count; ++i )
+                    curve.table[i] = u16( *offset + 12 + 2 * i ) / 65535.0;
+            }
+            return curve;
+        }
+
+        if( u32( *offset ) == signature( "para" ) )
+        {
+            curve.function = u16( *offset + 8 );
+            double *parameters[] = { &curve.g, &curve.a, &curve.b, &curve.c, &curve.d, &curve.e, &curve.f };
+            const unsigned counts[] = { 1, 3, 4, 5, 7 };
+            if( curve.function < 0 || curve.function > 4 )
+                return {};
+
+            for( unsigned i = 0; i < counts[curve.function]; ++i )
+                *parameters[i] = s15Fixed16( *offset + 12 + 4 * i );
+            return curve;
+        }
+
+        return {};
+    }
+
+    std::optional<std::array<double, 3>> xyz( const char *tag ) const
+    {
+        auto offset = find( tag );
+        if( !offset || u32( *offset ) != signature( "XYZ " ) )
+            return {};
+        return std::array<double, 3> { s15Fixed16( *offset + 8 ), s15Fixed16( *offset + 12 ), s15Fixed16( *offset + 16 ) };
+    }
+private:
+    const std::vector<uint8_t> &profile;
+
+    bool check( size_t offset, size_t bytes ) const
+    {
+        if( offset > profile.size() || bytes > profile.size() - offset )
+            failed = true;
+        return !failed;
+    }
+};
+
+static double encodeSrgb( double x )
+{
+    return x <= 0.0031308 ? 12.92 * x : 1.055 * std::pow( x, 1 / 2.4 ) - 0.055;
+}
+
+// 'supported' is false, if profile can't be read, then nullptr is returned
+static std::shared_ptr<const ColorLut> buildLut( const std::vector<uint8_t> &profile, bool &supported )
+{
+    supported = false;
+
+    ProfileReader r( profile );
+    if( profile.size() < 132 || r.u32( 16 ) != ProfileReader::signature( "RGB " ) || r.u32( 20 ) != ProfileReader::signature( "XYZ " ) )
+        return nullptr;
+
+    const char *columns[] = { "rXYZ", "gXYZ", "bXYZ" };
+    const char *curves[] = { "rTRC", "gTRC", "bTRC" };
+
+    double matrix[3][3];
+    ToneCurve tone[3];
+    for( unsigned i = 0; i < 3; ++i )
+    {
+        auto column = r.xyz( columns[i] );
+        auto curve = r.curve( curves[i] );
+        if( !column || !curve )
+            return nullptr;
+
+        for( unsigned j = 0; j < 3; ++j )
+            matrix[j][i] = ( *column )[j];
+        tone[i] = *curve;
+    }
+
+    if( r.failed )
+        return nullptr;
+
+    supported = true;
+
+    // Profile connection space is XYZ with D50 white, Bradford-adapted into linear sRGB with D65 white
+    const double toSrgb[3][3] =
+    {
+        {  3.1338561, -1.6168667, -0.4906146 },
+        { -0.9787684,  1.9161415,  0.0334540 },
+        {  0.0719453, -0.2289914,  1.4052427 }
+    };
+
+    double combined[3][3];
+    for( unsigned i = 0; i < 3; ++i )
+    {
+        for( unsigned j = 0; j < 3; ++j )
+        {
+            combined[i][j] = 0;
+            for( unsigned k = 0; k < 3; ++k )
+                combined[i][j] += toSrgb[i][k] * matrix[k][j];
+        }
+    }
+
+    // Tone curves are evaluated once for every grid position
+    double linear[3][LUT_GRID];
+    for( unsigned c = 0; c < 3; ++c )
+    {
+        for( unsigned i = 0; i < LUT_GRID; ++i )
+            linear[c][i] = tone[c]( double( i ) / ( LUT_GRID - 1 ) );
+    }
+
+    auto lut = std::make_shared<ColorLut>();
+    lut->grid = LUT_GRID;
+    lut->table.resize( 3 * LUT_GRID * LUT_GRID * LUT_GRID );
+
+    auto node = lut->table.data();
+    double deviation = 0;
+    for( unsigned ri = 0; ri < LUT_GRID; ++ri )
+    {
+        for( unsigned gi = 0; gi < LUT_GRID; ++gi )
+        {
+            for( unsigned bi = 0; bi < LUT_GRID; ++bi )
+            {
+                const double rgb[3] = { linear[0][ri], linear[1][gi], linear[2][bi] };
+                const unsigned index[3] = { ri, gi, bi };
+                for( unsigned c = 0; c < 3; ++c )
+                {
+                    double value = combined[c][0] * rgb[0] + combined[c][1] * rgb[1] + combined[c][2] * rgb[2];
+                    *node++ = uint16_t( Max( 0.0, Min( 65535.0, ( value + 1 ) * LUT_ZERO + 0.5 ) ) );
+
+                    double identity = double( index[c] ) / ( LUT_GRID - 1 );
+                    deviation = Max( deviation, Abs( encodeSrgb( Max( 0.0, Min( 1.0, value ) ) ) - identity ) );
+                }
+            }
+        }
+    }
+
+    // Profiles of sRGB itself round to the same 8-bit colors
+    if( deviation < 0.5 / 255 )
+        return nullptr;
+
+    return lut;
+}
+
+std::shared_ptr<const ColorLut> iccLut( const std::vector<uint8_t> &profile )
+{
+    // Front is the most recently used table, tables of sRGB profiles are kept as nullptr
+    using Entry = std::pair<uint64_t, std::shared_ptr<const ColorLut>>;
+    static std::mutex mutex;
+    static std::list<Entry> order;
+    static std::unordered_map<uint64_t, std::list<Entry>::iterator> luts;
+
+    if( profile.empty() )
+        return nullptr;
+
+    auto key = hash64( profile.data(), profile.size() );
+    {
+        std::lock_guard<std::mutex> lock( mutex );
+        auto found = luts.find( key );
+        if( found != luts.end() )
+        {
+            order.splice( order.begin(), order, found->second );
+            return found->second->second;
+        }
+    }
+
+    bool supported;
+    auto lut = buildLut( profile, supported );
+
+    // Profiles, that can't be read, are not remembered
+    if( !supported )
+        return nullptr;
+
+    std::lock_guard<std::mutex> lock( mutex );
+    if( luts.find( key ) == luts.end() )
+    {
+        order.emplace_front( key, lut );
+        luts.emplace( key, order.begin() );
+        while( order.size() > LUT_CACHE )
+        {
+            luts.erase( order.back().first );
+            order.pop_back();
+        }
+    }
+    return lut;
+}
+
+// Maps linear values in range [0, LUT_ZERO] into 8-bit sRGB
+static const uint8_t *encodeTable()
+{
+    static const auto table = []()
+    {
+        std::vector<uint8_t> result( LUT_ZERO + 1 );
+        for( unsigned i = 0; i < result.size(); ++i )
+            result[i] = uint8_t( encodeSrgb( double( i ) / LUT_ZERO ) * 255 + 0.5 );
+        return result;
+    }();
+    return table.data();
+}
+
+ColorProfile::ColorProfile( std::shared_ptr<const ColorLut> l, size_t s, const PixelFormat &pfmt ) : Compression( s, pfmt ), lut( std::move( l ) )
+{}
+
+void ColorProfile::compress( Format &, const Reference &, Reference & )
+{
+    // Transform isn't inverted, images are written in sRGB
+    makeException( false );
+}
+
+void ColorProfile::decompress( Format &fmt, const Reference &source, Reference &destination ) const
+{
+    makeException( fmt.compression.front().get() == this );
+    makeException( lut && lut->grid >= 2 );
+    makeException( channels.size() == 3 && bits == 24 && channels[0].bits == 8 && channels[1].bits == 8 &&
+                   id( 'R' ) == 0u && id( 'G' ) == 1u && id( 'B' ) == 2u );
+
+    auto srcFmt = fmt;
+    srcFmt.compression.clear();
+
+    fmt.offset = 0;
+    fmt.compression.pop_front();
+    fmt.copy( *this );
+    sync( fmt, destination );
+
+    size_t width = Abs( fmt.w ), height = Abs( fmt.h );
+    size_t srcStride = srcFmt.lineSize(), dstStride = fmt.lineSize();
+    makeException( source.bytes >= srcFmt.offset + height * srcStride && destination.bytes >= height * dstStride );
+
+    // Node offset and fraction for every 8-bit value, last value is at the end of the last cell
+    unsigned grid = lut->grid;
+    size_t strides[3] = { 3 * grid * grid, 3 * grid, 3 };
+    uint32_t offsets[3][256];
+    uint32_t fractions[256];
+    for( unsigned v = 0; v < 256; ++v )
+    {
+        uint32_t position = ( v * ( grid - 1 ) << LUT_FRACTION ) / 255;
+        uint32_t index = Min( position >> LUT_FRACTION, grid - 2 );
+        fractions[v] = position - ( index << LUT_FRACTION );
+        for( unsigned c = 0; c < 3; ++c )
+            offsets[c][v] = index * strides[c];
+    }
+
+    auto table = lut->table.data();
+    auto encode = encodeTable();
+    parallelFor( height, [&]( size_t begin, size_t end )
+    {
+        for( size_t y = begin; y < end; ++y )
+        {
+            auto in = ( const uint8_t * )source.link + srcFmt.offset + y * srcStride;
+            auto out = ( uint8_t * )destination.link + y * dstStride;
+
+            for( size_t x = 0; x < width; ++x, in += 3, out += 3 )
+            {
+                // Flat areas repeat colors, they are copied from the previous pixel
+                if( x > 0 && in[0] == in[-3] && in[1] == in[-2] && in[2] == in[-1] )
+                {
+                    out[0] = out[-3];
+                    out[1] = out[-2];
+                    out[2] = out[-1];
+                    continue;
+                }
+
+                // Cube is split into 6 tetrahedra by ordering fractions, path goes along axes of larger fractions first
+                int32_t fr = fractions[in[0]], fg = fractions[in[1]], fb = fractions[in[2]];
+                int32_t f0, f1, f2;
+                size_t s0, s1, s2;
+                if( fr >= fg )
+                {
+                    if( fg >= fb )
+                        f0 = fr, f1 = fg, f2 = fb, s0 = strides[0], s1 = strides[1], s2 = strides[2];
+                    else if( fr >= fb )
+                        f0 = fr, f1 = fb, f2 = fg, s0 = strides[0], s1 = strides[2], s2 = strides[1];
+                    else
+                        f0 = fb, f1 = fr, f2 = fg, s0 = strides[2], s1 = strides[0], s2 = strides[1];
+                }
+                else
+                {
+                    if( fr >= fb )
+                        f0 = fg, f1 = fr, f2 = fb, s0 = strides[1], s1 = strides[0], s2 = strides[2];
+                    else if( fg >= fb )
+                        f0 = fg, f1 = fb, f2 = fr, s0 = strides[1], s1 = strides[2], s2 = strides[0];
+                    else
+                        f0 = fb, f1 = fg, f2 = fr, s0 = strides[2], s1 = strides[1], s2 = strides[0];
+                }
+
+                auto p0 = table + offsets[0][in[0]] + offsets[1][in[1]] + offsets[2][in[2]];
+                auto p1 = p0 + s0;
+                auto p2 = p1 + s1;
+                auto p3 = p2 + s2;
+
+                for( unsigned k = 0; k < 3; ++k )
+                {
+                    int32_t value = ( int32_t( p0[k] ) << LUT_FRACTION ) +
+                                    ( int32_t( p1[k] ) - p0[k] ) * f0 + ( int32_t( p2[k] ) - p1[k] ) * f1 + ( int32_t( p3[k] ) - p2[k] ) * f2;
+
+                    value = ( value + ( 1 << ( LUT_FRACTION - 1 ) ) ) >> LUT_FRACTION;
+                    out[k] = encode[Max( 0, Min( LUT_ZERO, value - LUT_ZERO ) )];
+                }
+            }
+        }
+    }, 16 );
+}
+
+bool ColorProfile::equals( const Compression &other ) const
+{
+    if( auto profile = dynamic_cast<const ColorProfile *>( &other ) )
+        return lut == profile->lut && this->Compression::operator==( other );
+    return false;
+}
+}
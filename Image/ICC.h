@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <memory>
+
+#include "Image/Format.h"
+
+// https://www.color.org/specification/ICC.1-2022-05.pdf
+
+namespace ImageConvert
+{
+// Samples of color transform on regular grid, every axis has 'grid' nodes
+// Node (r, g, b) is at index 3 * ((r * grid + g) * grid + b), values are linear R, G, B
+// Linear value v is stored as (v + 1) * 16384, so values in range [-1, 3) are kept
+// Unclipped linear values are interpolated more accurately, than encoded ones, near black and near gamut boundary
+struct ColorLut
+{
+    unsigned grid;
+    std::vector<uint16_t> table;
+};
+
+// Returns transform from colors of ICC profile into linear sRGB
+// Only RGB profiles with matrix and tone curves are supported
+// Returns nullptr, if profile isn't supported or doesn't change 8-bit colors
+// Tables of recently used profiles are kept and shared between threads
+std::shared_ptr<const ColorLut> iccLut( const std::vector<uint8_t> &profile );
+
+// Converts R8G8B8 pixels into sRGB with tetrahedral interpolation in 3D table
+struct ColorProfile : public Compression
+{
+    std::shared_ptr<const ColorLut> lut;
+
+    ColorProfile( std::shared_ptr<const ColorLut> l, size_t s, const PixelFormat &pfmt );
+
+    void compress( Format &fmt, const Reference &source, Reference &destination ) override;
+    void decompress( Format &fmt, const Reference &source, Reference &destination ) const override;
+
+    bool equals( const Compression &other ) const override;
+};
+}
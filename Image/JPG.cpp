@@ -6,6 +6,7 @@
 #include <map>
 
 #include "Image/PixelIO.h"
+#include "Image/ICC.h"
 
 #include "Matrix3D.h"
 
@@ -218,6 +219,51 @@ bool SegmentEXIF::write( WriterBase &w ) const
     return true;
 }
 
+std::optional<unsigned> SegmentEXIF::orientation() const
+{
+    const char identifier[6] = {'E', 'x', 'i', 'f', 0, 0};
+    if( tiffData.size() < sizeof( identifier ) + 8 || !compare( tiffData.data(), identifier, sizeof( identifier ) ) )
+        return {};
+
+    auto tiff = tiffData.data() + sizeof( identifier );
+    size_t size = tiffData.size() - sizeof( identifier );
+
+    // TIFF header defines byte order
+    bool little = tiff[0] == 'I' && tiff[1] == 'I';
+    if( !little && !( tiff[0] == 'M' && tiff[1] == 'M' ) )
+        return {};
+
+    auto get = [&]( size_t offset, unsigned bytes ) -> uint32_t
+    {
+        uint32_t value = 0;
+        for( unsigned i = 0; i < bytes; ++i )
+            value |= uint32_t( tiff[offset + i] ) << ( 8 * ( little ? i : bytes - 1 - i ) );
+        return value;
+    };
+
+    size_t directory = get( 4, 4 );
+    if( directory + 2 > size )
+        return {};
+
+    unsigned entries = get( directory, 2 );
+    for( unsigned i = 0; i < entries; ++i )
+    {
+        size_t entry = directory + 2 + 12 * i;
+        if( entry + 12 > size )
+            return {};
+
+        // Orientation is a single SHORT
+        if( get( entry, 2 ) == 0x0112 )
+        {
+            unsigned value = get( entry + 8, 2 );
+            if( get( entry + 2, 2 ) != 3 || value < 1 || value > 8 )
+                return {};
+            return value;
+        }
+    }
+    return {};
+}
+
 bool SegmentICC::read( ReaderBase &r, uint16_t length )
 {
     if( length < sizeof( hdr ) )
@@ -1233,7 +1279,7 @@ struct IDCT
     }
 };
 
-Huffman::Huffman( std::shared_ptr<JPEG> img, unsigned s, const PixelFormat &pfmt ) :
+Huffman::Huffman( std::shared_ptr<JPEG> img, size_t s, const PixelFormat &pfmt ) :
     Compression( s, pfmt ),
     image( std::move( img ) ),
     sof( image->findSingle<SegmentSOF>() ),
@@ -1918,7 +1964,7 @@ bool Huffman::equals( const Compression &other ) const
     return false;
 }
 
-Arithmetic::Arithmetic( std::shared_ptr<JPEG> img, unsigned s, const PixelFormat &pfmt ) :
+Arithmetic::Arithmetic( std::shared_ptr<JPEG> img, size_t s, const PixelFormat &pfmt ) :
     Compression( s, pfmt ),
     image( std::move( img ) ),
     sof( image->findSingle<SegmentSOF>() ),
@@ -1948,7 +1994,7 @@ bool Arithmetic::equals( const Compression & ) const
     return false;
 }
 
-Quantization::Quantization( std::shared_ptr<JPEG> img, unsigned s, const PixelFormat &pfmt ) :
+Quantization::Quantization( std::shared_ptr<JPEG> img, size_t s, const PixelFormat &pfmt ) :
     Compression( s, pfmt ),
     image( std::move( img ) ),
     sof( image->findSingle<SegmentSOF>() ),
@@ -2071,7 +2117,7 @@ bool Quantization::equals( const Compression &other ) const
     return false;
 }
 
-DCT::DCT( std::shared_ptr<JPEG> img, unsigned s, const PixelFormat &pfmt ) :
+DCT::DCT( std::shared_ptr<JPEG> img, size_t s, const PixelFormat &pfmt ) :
     Compression( s, pfmt ),
     image( std::move( img ) ),
     sof( image->findSingle<SegmentSOF>() )
@@ -2131,7 +2177,7 @@ bool DCT::equals( const Compression &other ) const
     return false;
 }
 
-BlockGrouping::BlockGrouping( std::shared_ptr<JPEG> img, unsigned s, const PixelFormat &pfmt ) :
+BlockGrouping::BlockGrouping( std::shared_ptr<JPEG> img, size_t s, const PixelFormat &pfmt ) :
     Compression( s, pfmt ),
     image( std::move( img ) ),
     sof( image->findSingle<SegmentSOF>() )
@@ -2322,7 +2368,7 @@ bool BlockGrouping::equals( const Compression &other ) const
     return false;
 }
 
-Scale::Scale( std::shared_ptr<JPEG> img, unsigned s, const PixelFormat &pfmt ) :
+Scale::Scale( std::shared_ptr<JPEG> img, size_t s, const PixelFormat &pfmt ) :
     Compression( s, pfmt ),
     image( std::move( img ) ),
     sof( image->findSingle<SegmentSOF>() )
@@ -2542,7 +2588,7 @@ bool Scale::equals( const Compression &other ) const
     return false;
 }
 
-YCbCrK::YCbCrK( std::shared_ptr<JPEG> img, unsigned s, const PixelFormat &pfmt ) :
+YCbCrK::YCbCrK( std::shared_ptr<JPEG> img, size_t s, const PixelFormat &pfmt ) :
     Compression( s, pfmt ),
     image( std::move( img ) )
 {}
@@ -2696,7 +2742,7 @@ bool YCbCrK::equals( const Compression &other ) const
     return false;
 }
 
-CMYK::CMYK( std::shared_ptr<JPEG> img, unsigned s, const PixelFormat &pfmt ) :
+CMYK::CMYK( std::shared_ptr<JPEG> img, size_t s, const PixelFormat &pfmt ) :
     Compression( s, pfmt ),
     image( std::move( img ) )
 {}
@@ -2867,6 +2913,26 @@ static int extractColorModel( size_t size, const JPEG& image )
     return 0;
 }
 
+// Profile can be split into several segments, they are joined in order of sequence numbers
+static std::vector<uint8_t> iccProfile( const JPEG &image )
+{
+    auto segments = image.find<SegmentICC>();
+    std::vector<uint8_t> profile;
+    for( unsigned number = 1; number <= segments.size(); ++number )
+    {
+        auto segment = std::find_if( segments.begin(), segments.end(), [&]( const auto & s )
+        {
+            return s->hdr.seqNumber == number && compare( s->hdr.identifier, "ICC_PROFILE", 12 );
+        } );
+
+        if( segment == segments.end() )
+            return {};
+
+        profile.insert( profile.end(), ( *segment )->chunkData.begin(), ( *segment )->chunkData.end() );
+    }
+    return profile;
+}
+
 static void extractJpg( Format &fmt, ReaderBase &r )
 {
     auto img = std::make_shared<JPEG>();
@@ -2886,21 +2952,55 @@ static void extractJpg( Format &fmt, ReaderBase &r )
     auto size = sof->components.size();
     auto bits = sof->header.samplePrecision;
 
+    auto model = extractColorModel( size, image );
+
+    // Decoded pixels have one grey channel for single component, other color models are converted to RGB
     fmt.clear();
     fmt.pad = 1;
     fmt.offset = 0;
-    fmt.channels.push_back( { 'R', bits } );
-    fmt.channels.push_back( { 'G', bits } );
-    fmt.channels.push_back( { 'B', bits } );
+    if( model == 0 )
+    {
+        fmt.channels.push_back( { 'G', bits } );
+    }
+    else
+    {
+        fmt.channels.push_back( { 'R', bits } );
+        fmt.channels.push_back( { 'G', bits } );
+        fmt.channels.push_back( { 'B', bits } );
+    }
     fmt.calculateBits();
 
-    switch( extractColorModel( size, image ) )
+    // Stored image is turned to be shown as EXIF orientation requires, XMP also uses APP1 segments
+    for( auto exif : image.find<SegmentEXIF>() )
     {
-    case 0:
-        fmt.clear();
-        fmt.channels.push_back( { 'G', bits } );
-        fmt.calculateBits();
+        auto orientation = exif->orientation();
+        if( !orientation )
+            continue;
+
+        if( *orientation > 1 )
+        {
+            //                          1      2      3      4      5      6      7      8
+            const bool mirrorX[8]   = {false, true,  true,  false, false, true,  true,  false};
+            const bool mirrorY[8]   = {false, false, true,  true,  false, false, true,  true };
+            const bool transpose[8] = {false, false, false, false, true,  true,  true,  true };
+
+            auto i = *orientation - 1;
+            std::optional<Pixel> p;
+            fmt.compression.push_front( std::make_shared<Misc>( fmt.bufferSize(), mirrorX[i], mirrorY[i], p, fmt, transpose[i] ) );
+        }
         break;
+    }
+
+    // Colors of RGB and YCbCr images are converted from embedded ICC profile into sRGB
+    if( ( model == 1 || model == 2 ) && bits == 8 )
+    {
+        if( auto lut = iccLut( iccProfile( image ) ) )
+            fmt.compression.push_front( std::make_shared<ColorProfile>( lut, fmt.bufferSize(), fmt ) );
+    }
+
+    switch( model )
+    {
+    case 0:
     case 1:
         break;
     case 2:
@@ -2933,8 +3033,6 @@ static void extractJpg( Format &fmt, ReaderBase &r )
         makeException( false );
     }
 
-    // SegmentICC contains data needed for color management
-
     auto sof0 = image.findSingle<SegmentSOF0>();
     auto dri = image.findSingle<SegmentDRI>();
     auto dht = image.find<SegmentDHT>();
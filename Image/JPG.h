@@ -143,6 +143,9 @@ struct SegmentEXIF : public JPEG::Segment
 
     bool read( ReaderBase &r, uint16_t length ) override;
     bool write( WriterBase &w ) const override;
+
+    // Value of Orientation tag from 1 to 8, if it's present in the first directory
+    std::optional<unsigned> orientation() const;
 };
 
 // ICC (APP2)
@@ -445,7 +448,7 @@ struct Huffman : public Compression
     std::vector<const SegmentDHT*> dht;
     std::vector<const SegmentSOS*> sos;
 
-    Huffman( std::shared_ptr<JPEG> image, unsigned s, const PixelFormat &pfmt );
+    Huffman( std::shared_ptr<JPEG> image, size_t s, const PixelFormat &pfmt );
 
     void compress( Format &fmt, const Reference &source, Reference &destination ) override;
 
@@ -466,7 +469,7 @@ struct Arithmetic : public Compression
     std::vector<const SegmentDAC*> dac;
     std::vector<const SegmentSOS*> sos;
 
-    Arithmetic( std::shared_ptr<JPEG> image, unsigned s, const PixelFormat &pfmt );
+    Arithmetic( std::shared_ptr<JPEG> image, size_t s, const PixelFormat &pfmt );
 
     void compress( Format &fmt, const Reference &source, Reference &destination ) override;
     void decompress( Format &fmt, const Reference &source, Reference &destination ) const override;
@@ -481,7 +484,7 @@ struct Quantization : public Compression
     const SegmentSOF* sof;
     std::vector<const SegmentDQT*> dqt;
 
-    Quantization( std::shared_ptr<JPEG> image, unsigned s, const PixelFormat &pfmt );
+    Quantization( std::shared_ptr<JPEG> image, size_t s, const PixelFormat &pfmt );
 
     void compress( Format &fmt, const Reference &source, Reference &destination ) override;
 
@@ -498,7 +501,7 @@ struct DCT : public Compression
 
     const SegmentSOF* sof;
 
-    DCT( std::shared_ptr<JPEG> image, unsigned s, const PixelFormat &pfmt );
+    DCT( std::shared_ptr<JPEG> image, size_t s, const PixelFormat &pfmt );
 
     void compress( Format &fmt, const Reference &source, Reference &destination ) override;
 
@@ -516,7 +519,7 @@ struct BlockGrouping : public Compression
 
     const SegmentSOF* sof;
 
-    BlockGrouping( std::shared_ptr<JPEG> image, unsigned s, const PixelFormat &pfmt );
+    BlockGrouping( std::shared_ptr<JPEG> image, size_t s, const PixelFormat &pfmt );
 
     void compress( Format &fmt, const Reference &source, Reference &destination ) override;
 
@@ -533,7 +536,7 @@ struct Scale : public Compression
 
     const SegmentSOF* sof;
 
-    Scale( std::shared_ptr<JPEG> image, unsigned s, const PixelFormat &pfmt );
+    Scale( std::shared_ptr<JPEG> image, size_t s, const PixelFormat &pfmt );
 
     void compress( Format &fmt, const Reference &source, Reference &destination ) override;
 
@@ -549,7 +552,7 @@ struct YCbCrK : public Compression
 {
     std::shared_ptr<JPEG> image;
 
-    YCbCrK( std::shared_ptr<JPEG> image, unsigned s, const PixelFormat &pfmt );
+    YCbCrK( std::shared_ptr<JPEG> image, size_t s, const PixelFormat &pfmt );
 
     void compress( Format &fmt, const Reference &source, Reference &destination ) override;
 
@@ -565,7 +568,7 @@ struct CMYK : public Compression
 {
     std::shared_ptr<JPEG> image;
 
-    CMYK( std::shared_ptr<JPEG> image, unsigned s, const PixelFormat &pfmt );
+    CMYK( std::shared_ptr<JPEG> image, size_t s, const PixelFormat &pfmt );
 
     void compress( Format &fmt, const Reference &source, Reference &destination ) override;
 
@@ -0,0 +1,202 @@
+#include "Image/Metrics.h"
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include <cmath>
+
+#include "Image/Translate.h"
+
+#include "Exception.h"
+#include "Parallel.h"
+#include "BitIO.h"
+#include "Basic.h"
+
+namespace ImageConvert
+{
+// Window of structural similarity and its step
+#define SSIM_WINDOW 8
+#define SSIM_STEP 4
+
+// Squared errors of every line and column sums of x, y, x^2, y^2, xy for SSIM windows are exact 64-bit integers
+// Lines and rows of windows keep own results, they are added in order afterwards, so any number of threads gives the same values
+template<typename T>
+struct Measure
+{
+    static constexpr uint32_t max = std::numeric_limits<T>::max();
+
+    static inline uint32_t value( T x )
+    {
+        if constexpr( sizeof( T ) == 1 )
+            return x;
+        else
+            return swapBe16( x );
+    }
+
+    // Per channel sums of squared differences and largest differences
+    static void errors( const T *a, const T *b, size_t count, uint64_t *squares, uint32_t *largest )
+    {
+        uint64_t sum[4] = {};
+        uint32_t top[4] = {};
+        for( size_t i = 0; i < count; ++i, a += 4, b += 4 )
+        {
+            for( unsigned c = 0; c < 4; ++c )
+            {
+                uint32_t x = value( a[c] ), y = value( b[c] );
+                uint32_t e = x > y ? x - y : y - x;
+                sum[c] += uint64_t( e ) * e;
+                top[c] = Max( top[c], e );
+            }
+        }
+
+        for( unsigned c = 0; c < 4; ++c )
+        {
+            squares[c] = sum[c];
+            largest[c] = top[c];
+        }
+    }
+
+    // Adds similarities of windows, that start at line 'a', to 'similarity', per channel
+    // 'columns' keeps sums of x, y, x^2, y^2, xy over window's lines for every value of the line
+    static void windows( const T *a, const T *b, size_t w, unsigned lines, unsigned width, std::vector<uint64_t> &columns, double *similarity )
+    {
+        size_t values = 4 * w;
+        columns.assign( 5 * values, 0 );
+        auto sx = columns.data(), sy = sx + values, sxx = sy + values, syy = sxx + values, sxy = syy + values;
+
+        for( unsigned l = 0; l < lines; ++l, a += values, b += values )
+        {
+            for( size_t i = 0; i < values; ++i )
+            {
+                uint64_t x = value( a[i] ), y = value( b[i] );
+                sx[i] += x;
+                sy[i] += y;
+                sxx[i] += x * x;
+                syy[i] += y * y;
+                sxy[i] += x * y;
+            }
+        }
+
+        // Constants of the original definition for normalized values
+        constexpr double c1 = 0.01 * 0.01, c2 = 0.03 * 0.03;
+        double n = double( width ) * lines;
+        double scale = 1.0 / ( n * max ), scale2 = scale / max;
+
+        for( size_t x0 = 0; x0 + width <= w; x0 += SSIM_STEP )
+        {
+            for( unsigned c = 0; c < 4; ++c )
+            {
+                uint64_t s[5] = {};
+                for( size_t i = 4 * x0 + c; i < 4 * ( x0 + width ); i += 4 )
+                {
+                    s[0] += sx[i];
+                    s[1] += sy[i];
+                    s[2] += sxx[i];
+                    s[3] += syy[i];
+                    s[4] += sxy[i];
+                }
+
+                double mx = s[0] * scale, my = s[1] * scale;
+                double vx = s[2] * scale2 - mx * mx, vy = s[3] * scale2 - my * my, cxy = s[4] * scale2 - mx * my;
+                similarity[c] += ( ( 2 * mx * my + c1 ) * ( 2 * cxy + c2 ) ) / ( ( mx * mx + my * my + c1 ) * ( vx + vy + c2 ) );
+            }
+        }
+    }
+
+    static void measure( const Reference &a, const Reference &b, Difference &result )
+    {
+        size_t w = a.w, h = a.h, values = 4 * w;
+        auto linesA = ( const T * )a.link;
+        auto linesB = ( const T * )b.link;
+
+        std::vector<uint64_t> squares( 4 * h );
+        std::vector<uint32_t> largest( 4 * h );
+        parallelFor( h, [&]( size_t begin, size_t end )
+        {
+            for( size_t y = begin; y < end; ++y )
+                errors( linesA + y * values, linesB + y * values, w, &squares[4 * y], &largest[4 * y] );
+        }, 16 );
+
+        // Images smaller than a window are measured as one window
+        unsigned width = Min( w, ( size_t )SSIM_WINDOW ), height = Min( h, ( size_t )SSIM_WINDOW );
+        size_t rows = ( h - height ) / SSIM_STEP + 1, perRow = ( w - width ) / SSIM_STEP + 1;
+
+        std::vector<double> similarity( 4 * rows );
+        parallelFor( rows, [&]( size_t begin, size_t end )
+        {
+            std::vector<uint64_t> columns;
+            for( size_t r = begin; r < end; ++r )
+            {
+                size_t y0 = r * SSIM_STEP;
+                windows( linesA + y0 * values, linesB + y0 * values, w, height, width, columns, &similarity[4 * r] );
+            }
+        }, 4 );
+
+        for( unsigned c = 0; c < 4; ++c )
+        {
+            double sum = 0, ssim = 0;
+            uint32_t top = 0;
+            for( size_t y = 0; y < h; ++y )
+            {
+                sum += squares[4 * y + c];
+                top = Max( top, largest[4 * y + c] );
+            }
+            for( size_t r = 0; r < rows; ++r )
+                ssim += similarity[4 * r + c];
+
+            result.mse[c] = sum / ( double( w ) * h * max * max );
+            result.maxError[c] = double( top ) / max;
+            result.ssim[c] = ssim / ( double( rows ) * perRow );
+        }
+    }
+};
+
+static double psnr( double mse )
+{
+    return mse > 0 ? 10 * std::log10( 1 / mse ) : std::numeric_limits<double>::infinity();
+}
+
+// Images, that are already top-down RGBA of needed depth, are measured without translation
+static const Reference &pixels( const Reference &image, bool deep, Reference &storage )
+{
+    if( image.format == ( deep ? "R16G16B16A16" : "R8G8B8A8" ) && image.link && image.w > 0 && image.h > 0 &&
+            image.bytes >= ( deep ? 8 : 4 ) * size_t( image.w ) * image.h )
+        return image;
+
+    storage = unpackRgba( image, deep );
+    return storage;
+}
+
+Difference difference( const Reference &a, const Reference &b )
+{
+    bool deep = Max( channelDepth( a ), channelDepth( b ) ) > 8;
+
+    Reference storageA, storageB;
+    auto &pixelsA = pixels( a, deep, storageA );
+    auto &pixelsB = pixels( b, deep, storageB );
+    makeException( pixelsA.w == pixelsB.w && pixelsA.h == pixelsB.h && pixelsA.w > 0 && pixelsA.h > 0 );
+
+    Difference result;
+    if( deep )
+        Measure<uint16_t>::measure( pixelsA, pixelsB, result );
+    else
+        Measure<uint8_t>::measure( pixelsA, pixelsB, result );
+
+    result.colorMse = result.colorSsim = result.colorMaxError = 0;
+    for( unsigned c = 0; c < 4; ++c )
+    {
+        result.psnr[c] = psnr( result.mse[c] );
+        if( c < 3 )
+        {
+            result.colorMse += result.mse[c];
+            result.colorSsim += result.ssim[c];
+            result.colorMaxError = Max( result.colorMaxError, result.maxError[c] );
+        }
+    }
+    result.colorMse /= 3;
+    result.colorSsim /= 3;
+    result.colorPsnr = psnr( result.colorMse );
+
+    return result;
+}
+}
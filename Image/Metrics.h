@@ -0,0 +1,31 @@
+#pragma once
+
+#include "Image/Reference.h"
+
+namespace ImageConvert
+{
+// Differences between two images of the same size
+// Channels are R, G, B and A, values are normalized to [0, 1], so results of different depths are comparable
+struct Difference
+{
+    // Mean squared error
+    double mse[4];
+
+    // Peak signal-to-noise ratio in decibels, infinite for equal channels
+    double psnr[4];
+
+    // Mean structural similarity of 8x8 windows, placed every 4 pixels, 1 for equal channels
+    double ssim[4];
+
+    // Largest absolute difference of a single value
+    double maxError[4];
+
+    // Same measures for color channels R, G, B together
+    double colorMse, colorPsnr, colorSsim, colorMaxError;
+};
+
+// Both images are translated into the same top-down RGBA format first, so any formats can be compared
+// 16 bits per channel are used, if any image has deeper channels than 8 bits
+// Lines are processed on several threads
+Difference difference( const Reference &a, const Reference &b );
+}
@@ -1,5 +1,8 @@
 #include "Image/PNG.h"
 
+#include <algorithm>
+#include <limits>
+
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wall"
 #pragma GCC diagnostic ignored "-Wextra"
@@ -7,8 +10,11 @@
 #include <zlib.h>
 #pragma GCC diagnostic pop
 
+#include "Image/Translate.h"
 #include "Image/PixelIO.h"
 
+#include "Lambda.h"
+
 namespace ImageConvert
 {
 #define PNG_GRAYSCALE 0
@@ -160,7 +166,7 @@ unsigned PNGChunk::size() const
     return sizeof( meta ) + meta.length + sizeof( crc );
 }
 
-FracturePng::FracturePng( unsigned s, const PixelFormat &pfmt ) : Compression( s, pfmt )
+FracturePng::FracturePng( size_t s, const PixelFormat &pfmt ) : Compression( s, pfmt )
 {}
 
 void FracturePng::compress( Format &fmt, const Reference &source, Reference &destination )
@@ -235,9 +241,25 @@ bool FracturePng::equals( const Compression &other ) const
     return false;
 };
 
-ZlibPng::ZlibPng( unsigned s, const PixelFormat &pfmt ) : Compression( s, pfmt )
+ZlibPng::ZlibPng( size_t s, const PixelFormat &pfmt ) : Compression( s, pfmt )
 {}
 
+// zlib counts bytes in 32-bit integers, so buffers are given to it by pieces of at most this size
+static void feedZlib( z_stream &strm, size_t &inLeft, size_t &outLeft )
+{
+    const size_t piece = std::numeric_limits<uInt>::max();
+    if( strm.avail_in == 0 && inLeft > 0 )
+    {
+        strm.avail_in = uInt( std::min( inLeft, piece ) );
+        inLeft -= strm.avail_in;
+    }
+    if( strm.avail_out == 0 && outLeft > 0 )
+    {
+        strm.avail_out = uInt( std::min( outLeft, piece ) );
+        outLeft -= strm.avail_out;
+    }
+}
+
 void ZlibPng::compress( Format &fmt, const Reference &source, Reference &destination )
 {
     makeException( fmt.compression.front().get() == this );
@@ -249,19 +271,35 @@ void ZlibPng::compress( Format &fmt, const Reference &source, Reference &destina
     fmt.offset = 0;
     fmt.clear();
 
-    std::vector<uint8_t> outBuffer( srcSize + 1000 ); // ???
-
     z_stream strm = {};
     makeException( deflateInit( &strm, Z_BEST_COMPRESSION ) == Z_OK );
 
-    strm.avail_in = srcSize;
+    // Incompressible data grows by headers of stored blocks, zlib gives the worst case for every piece
+    size_t bound = 0, left = srcSize;
+    do
+    {
+        auto piece = uLong( std::min<size_t>( left, std::numeric_limits<uInt>::max() ) );
+        bound = sizeSum( bound, deflateBound( &strm, piece ) );
+        left -= piece;
+    }
+    while( left > 0 );
+    std::vector<uint8_t> outBuffer( bound );
+
+    size_t inLeft = srcSize, outLeft = outBuffer.size();
     strm.next_in = srcData;
-    strm.avail_out = outBuffer.size();
     strm.next_out = outBuffer.data();
-    makeException( deflate( &strm, Z_FINISH ) == Z_STREAM_END );
+
+    int result;
+    do
+    {
+        feedZlib( strm, inLeft, outLeft );
+        result = deflate( &strm, inLeft == 0 ? Z_FINISH : Z_NO_FLUSH );
+        makeException( result == Z_OK || result == Z_STREAM_END );
+    }
+    while( result != Z_STREAM_END );
     deflateEnd( &strm );
 
-    outBuffer.resize( outBuffer.size() - strm.avail_out );
+    outBuffer.resize( strm.next_out - outBuffer.data() );
     size = outBuffer.size();
     sync( fmt, destination );
 
@@ -273,7 +311,7 @@ void ZlibPng::decompress( Format &fmt, const Reference &source, Reference &desti
     makeException( fmt.compression.front().get() == this );
 
     z_stream strm = {};
-    strm.avail_in = source.bytes - fmt.offset;
+    size_t inLeft = source.bytes - fmt.offset;
     strm.next_in = ( Bytef * )( ( const uint8_t * )source.link + fmt.offset );
     makeException( inflateInit( &strm ) == Z_OK );
 
@@ -282,15 +320,20 @@ void ZlibPng::decompress( Format &fmt, const Reference &source, Reference &desti
     fmt.copy( *this );
     sync( fmt, destination );
 
-    std::vector<uint8_t> outBuffer( fmt.bufferSize() + 1000 ); // ???
-    strm.avail_out = outBuffer.size();
+    std::vector<uint8_t> outBuffer( fmt.bufferSize() );
+    size_t outLeft = outBuffer.size();
     strm.next_out = outBuffer.data();
 
-    auto result = inflate( &strm, Z_FINISH );
-    makeException( result == Z_STREAM_END );
+    int result;
+    do
+    {
+        feedZlib( strm, inLeft, outLeft );
+        result = inflate( &strm, Z_NO_FLUSH );
+        makeException( result == Z_OK || result == Z_STREAM_END );
+    }
+    while( result != Z_STREAM_END );
     inflateEnd( &strm );
 
-    outBuffer.resize( outBuffer.size() - strm.avail_out );
     ::copy( destination.link, outBuffer.data(), destination.bytes );
 }
 
@@ -331,14 +374,14 @@ FilterAndInterlacePng::Size::Size( const Step &step, unsigned w, unsigned h )
     number = ( h > step.startY ) ? ( ( h - step.startY + step.incY - 1 ) / step.incY ) : 0;
 }
 
-unsigned FilterAndInterlacePng::Size::lineBytes( unsigned bits ) const
+size_t FilterAndInterlacePng::Size::lineBytes( unsigned bits ) const
 {
-    return 1 + ( scanline * bits + 7 ) / 8;
+    return 1 + ( ( size_t )scanline * bits + 7 ) / 8;
 }
 
-unsigned FilterAndInterlacePng::Size::bytes( unsigned bits ) const
+size_t FilterAndInterlacePng::Size::bytes( unsigned bits ) const
 {
-    return number * lineBytes( bits );
+    return sizeProduct( number, lineBytes( bits ) );
 }
 
 bool FilterAndInterlacePng::Size::empty() const
@@ -434,6 +477,86 @@ std::vector<BitList> FilterAndInterlacePng::applyFilter(
     return result;
 }
 
+void FilterAndInterlacePng::unfilterLine( uint8_t *line, const uint8_t *previous, size_t bytes, unsigned pixelBytes, unsigned filterType )
+{
+    size_t i = 0;
+    switch( filterType )
+    {
+    case PNG_NONE:
+        break;
+    case PNG_SUB:
+        for( i = pixelBytes; i < bytes; ++i )
+            line[i] += line[i - pixelBytes];
+        break;
+    case PNG_UP:
+        if( previous )
+        {
+            for( ; i < bytes; ++i )
+                line[i] += previous[i];
+        }
+        break;
+    case PNG_AVERAGE:
+        if( previous )
+        {
+            for( ; i < pixelBytes && i < bytes; ++i )
+                line[i] += previous[i] / 2;
+            for( ; i < bytes; ++i )
+                line[i] += ( line[i - pixelBytes] + previous[i] ) / 2;
+        }
+        else
+        {
+            for( i = pixelBytes; i < bytes; ++i )
+                line[i] += line[i - pixelBytes] / 2;
+        }
+        break;
+    case PNG_PAETH:
+        if( previous )
+        {
+            for( ; i < pixelBytes && i < bytes; ++i )
+                line[i] += previous[i];
+            for( ; i < bytes; ++i )
+                line[i] += paethPredictor( line[i - pixelBytes], previous[i], previous[i - pixelBytes] );
+        }
+        else
+        {
+            // Predictor is the left neighbour, same as for PNG_SUB
+            for( i = pixelBytes; i < bytes; ++i )
+                line[i] += line[i - pixelBytes];
+        }
+        break;
+    default:
+        makeException( false );
+    }
+}
+
+void FilterAndInterlacePng::filterLine( const uint8_t *line, const uint8_t *previous, uint8_t *result, size_t bytes, unsigned pixelBytes, unsigned filterType )
+{
+    for( size_t i = 0; i < bytes; ++i )
+    {
+        int left = i >= pixelBytes ? line[i - pixelBytes] : 0;
+        int up = previous ? previous[i] : 0;
+        int upLeft = i >= pixelBytes && previous ? previous[i - pixelBytes] : 0;
+
+        int prediction = 0;
+        switch( filterType )
+        {
+        case PNG_SUB:
+            prediction = left;
+            break;
+        case PNG_UP:
+            prediction = up;
+            break;
+        case PNG_AVERAGE:
+            prediction = ( left + up ) / 2;
+            break;
+        case PNG_PAETH:
+            prediction = paethPredictor( left, up, upLeft );
+            break;
+        }
+        result[i] = uint8_t( line[i] - prediction );
+    }
+}
+
 FilterAndInterlacePng::FilterAndInterlacePng( bool i, int width, int height, const PixelFormat &pfmt )
     : Compression( 0, pfmt ), interlaced( i ), w( width ), h( height )
 {
@@ -472,6 +595,12 @@ void FilterAndInterlacePng::compress( Format &fmt, const Reference &source, Refe
 {
     makeException( fmt.compression.front().get() == this );
 
+    if( bits % 8 == 0 )
+    {
+        compressBytes( fmt, source, destination );
+        return;
+    }
+
     auto fmtSrc = fmt;
     PixelReader sourcePixelReader( fmtSrc, source );
     fmtSrc.offset = 0;
@@ -603,6 +732,12 @@ void FilterAndInterlacePng::decompress( Format &fmt, const Reference &source, Re
 {
     makeException( fmt.compression.front().get() == this );
 
+    if( bits % 8 == 0 )
+    {
+        decompressBytes( fmt, source, destination );
+        return;
+    }
+
     Reader sourceReader( source.link, source.bytes, fmt.offset );
 
     fmt.offset = 0;
@@ -710,6 +845,161 @@ void FilterAndInterlacePng::decompress( Format &fmt, const Reference &source, Re
     }
 }
 
+void FilterAndInterlacePng::compressBytes( Format &fmt, const Reference &source, Reference &destination )
+{
+    auto srcFmt = fmt;
+    srcFmt.compression.clear();
+
+    unsigned width = Abs( fmt.w );
+    unsigned height = Abs( fmt.h );
+    w = width;
+    h = height;
+    calculateSize();
+
+    copy( fmt );
+    fmt.offset = 0;
+    fmt.clear();
+    sync( size, fmt, destination );
+
+    size_t stride = srcFmt.lineSize();
+    makeException( source.bytes >= srcFmt.offset + height * stride && destination.bytes >= size );
+
+    auto input = ( const uint8_t * )source.link + srcFmt.offset;
+    auto output = ( uint8_t * )destination.link;
+    unsigned pixelBytes = bits / 8;
+
+    std::vector<uint8_t> gathered[2], candidate, best;
+
+    auto putPass = [&]( const Size & passSize, const Step * step )
+    {
+        auto bytes = passSize.lineBytes( bits ) - 1;
+        gathered[0].resize( bytes );
+        gathered[1].resize( bytes );
+        candidate.resize( bytes );
+        best.resize( bytes );
+
+        const uint8_t *previous = nullptr;
+        for( unsigned py = 0; py < passSize.number; ++py )
+        {
+            // Lines without interlacing are filtered right in the source
+            const uint8_t *line;
+            if( step )
+            {
+                auto row = input + step->y( py ) * stride;
+                auto &pixels = gathered[py % 2];
+                for( unsigned px = 0; px < passSize.scanline; ++px )
+                    ::copy( pixels.data() + px * pixelBytes, row + step->x( px ) * pixelBytes, pixelBytes );
+                line = pixels.data();
+            }
+            else
+            {
+                line = input + py * stride;
+            }
+
+            // Filter with the lowest sum of absolute signed bytes is chosen
+            unsigned bestFilter = 0, bestScore = ~0u;
+            for( unsigned filter = 0; filter < 5; ++filter )
+            {
+                filterLine( line, previous, candidate.data(), bytes, pixelBytes, filter );
+
+                unsigned score = 0;
+                for( size_t i = 0; i < bytes; ++i )
+                    score += Abs( int( int8_t( candidate[i] ) ) );
+
+                if( score < bestScore )
+                {
+                    bestScore = score;
+                    bestFilter = filter;
+                    best.swap( candidate );
+                }
+            }
+
+            *output++ = bestFilter;
+            ::copy( output, best.data(), bytes );
+            output += bytes;
+            previous = line;
+        }
+    };
+
+    if( interlaced )
+    {
+        for( unsigned pass = 0; pass < 7; ++pass )
+        {
+            Step passStep( pass );
+            Size passSize( passStep, width, height );
+
+            if( !passSize.empty() )
+                putPass( passSize, &passStep );
+        }
+    }
+    else
+    {
+        putPass( Size( width, height ), nullptr );
+    }
+}
+
+void FilterAndInterlacePng::decompressBytes( Format &fmt, const Reference &source, Reference &destination ) const
+{
+    auto offset = fmt.offset;
+
+    fmt.offset = 0;
+    fmt.compression.pop_front();
+    fmt.copy( *this );
+    sync( fmt, destination );
+
+    unsigned width = Abs( fmt.w );
+    unsigned height = Abs( fmt.h );
+
+    size_t stride = fmt.lineSize();
+    makeException( source.bytes >= offset + size && destination.bytes >= height * stride );
+
+    auto input = ( const uint8_t * )source.link + offset;
+    auto output = ( uint8_t * )destination.link;
+    unsigned pixelBytes = bits / 8;
+
+    std::vector<uint8_t> lines[2];
+
+    auto getPass = [&]( const Size & passSize, const Step * step )
+    {
+        auto bytes = passSize.lineBytes( bits ) - 1;
+        lines[0].resize( bytes );
+        lines[1].resize( bytes );
+
+        const uint8_t *previous = nullptr;
+        for( unsigned py = 0; py < passSize.number; ++py, input += bytes + 1 )
+        {
+            // Lines without interlacing are unfiltered right in the destination
+            uint8_t *line = step ? lines[py % 2].data() : output + py * stride;
+            ::copy( line, input + 1, bytes );
+            unfilterLine( line, previous, bytes, pixelBytes, input[0] );
+            previous = line;
+
+            if( step )
+            {
+                auto row = output + step->y( py ) * stride;
+                for( unsigned px = 0; px < passSize.scanline; ++px )
+                    ::copy( row + step->x( px ) * pixelBytes, line + px * pixelBytes, pixelBytes );
+            }
+        }
+    };
+
+    if( interlaced )
+    {
+        for( unsigned pass = 0; pass < 7; ++pass )
+        {
+            Step passStep( pass );
+            Size passSize( passStep, width, height );
+
+            if( !passSize.empty() )
+                getPass( passSize, &passStep );
+        }
+    }
+    else
+    {
+        getPass( Size( width, height ), nullptr );
+    }
+}
+
 bool FilterAndInterlacePng::equals( const Compression &other ) const
 {
     if( auto fip = dynamic_cast<const FilterAndInterlacePng *>( &other ) )
@@ -720,6 +1010,8 @@ bool FilterAndInterlacePng::equals( const Compression &other ) const
     return false;
 };
 
+static void buildPng( Format &fmt, const PNGIHDRData &ihdr, std::optional<PNGChunk> &plte, std::optional<PNGChunk> &trns );
+
 static void extractPng( Format &fmt, ReaderBase &r )
 {
     PNGSignature sgntr;
@@ -743,14 +1035,14 @@ static void extractPng( Format &fmt, ReaderBase &r )
 
     // Extracting meta data from other chunks and calculating data size
     PNGChunk chunk;
-    unsigned volume = 0, chunks = 0;
+    size_t volume = 0, chunks = 0;
     std::optional<PNGChunk> plte, trns;
     while( chunk.read( r, include ) )
     {
-        chunks += chunk.size();
+        chunks = sizeSum( chunks, chunk.size() );
         if( chunk.meta.is( "IDAT" ) )
         {
-            volume += chunk.meta.length;
+            volume = sizeSum( volume, chunk.meta.length );
         }
         else if( chunk.meta.is( "PLTE" ) )
         {
@@ -764,6 +1056,19 @@ static void extractPng( Format &fmt, ReaderBase &r )
         }
     }
 
+    fmt.offset = sizeof( sgntr ) + ihdrChunk.size();
+    buildPng( fmt, ihdr, plte, trns );
+
+    fmt.compression.push_front( std::make_shared<ZlibPng>( volume, fmt ) );
+    fmt.clear();
+
+    fmt.compression.push_front( std::make_shared<FracturePng>( chunks, fmt ) );
+    fmt.clear();
+}
+
+// Makes layers from pixels up to filtering, 'fmt' has to hold image size and offset
+static void buildPng( Format &fmt, const PNGIHDRData &ihdr, std::optional<PNGChunk> &plte, std::optional<PNGChunk> &trns )
+{
     if( ihdr.colorType == PNG_TRUECOLOR || ihdr.colorType == PNG_TRUECOLOR_ALPHA )
         plte.reset();
 
@@ -773,7 +1078,6 @@ static void extractPng( Format &fmt, ReaderBase &r )
     fmt.clear();
     fmt.pad = 1;
     fmt.bits = ihdr.bitDepth;
-    fmt.offset = sizeof( sgntr ) + ihdrChunk.size();
 
     switch( ihdr.colorType )
     {
@@ -934,15 +1238,9 @@ static void extractPng( Format &fmt, ReaderBase &r )
 
     fmt.compression.push_front( std::make_shared<FilterAndInterlacePng>( ihdr.interlaceMethod == 1, Abs( fmt.w ), Abs( fmt.h ), fmt ) );
     fmt.clear();
-
-    fmt.compression.push_front( std::make_shared<ZlibPng>( volume, fmt ) );
-    fmt.clear();
-
-    fmt.compression.push_front( std::make_shared<FracturePng>( chunks, fmt ) );
-    fmt.clear();
 }
 
-void makePng( const Reference &ref, Format &format, HeaderWriter *write )
+void makePng( const Reference &ref, Format &format, HeaderWriter *write, unsigned depth )
 {
     format.w = ref.w;
     format.h = ref.h;
@@ -954,11 +1252,13 @@ void makePng( const Reference &ref, Format &format, HeaderWriter *write )
         return;
     }
 
+    makeException( depth == 8 || depth == 16 );
+
     format.offset += sizeof( PNGSignature ) + sizeof( PNGChunkHeader ) + sizeof( PNGIHDRData ) + sizeof( PNGChunk::crc );
-    format.channels.push_back( { 'R', 8 } );
-    format.channels.push_back( { 'G', 8 } );
-    format.channels.push_back( { 'B', 8 } );
-    format.channels.push_back( { 'A', 8 } );
+    format.channels.push_back( { 'R', depth } );
+    format.channels.push_back( { 'G', depth } );
+    format.channels.push_back( { 'B', depth } );
+    format.channels.push_back( { 'A', depth } );
     format.calculateBits();
 
     std::optional<Pixel> p;
@@ -973,7 +1273,7 @@ void makePng( const Reference &ref, Format &format, HeaderWriter *write )
     format.compression.push_front( std::make_shared<FracturePng>( 0, format ) );
     format.clear();
 
-    *write = []( const Format & fmt, Reference & dst )
+    *write = [depth]( const Format & fmt, Reference & dst )
     {
         SimpleWriter w( dst.link, dst.bytes );
 
@@ -983,7 +1283,7 @@ void makePng( const Reference &ref, Format &format, HeaderWriter *write )
         PNGIHDRData ihdr;
         ihdr.width = swapBe32( fmt.w );
         ihdr.height = swapBe32( fmt.h );
-        ihdr.bitDepth = 8;
+        ihdr.bitDepth = depth;
         ihdr.colorType = PNG_TRUECOLOR_ALPHA;
         ihdr.compressionMethod = 0;
         ihdr.filterMethod = 0;
@@ -999,4 +1299,222 @@ void makePng( const Reference &ref, Format &format, HeaderWriter *write )
         makeException( ihdrChunk.write( w ) );
     };
 }
+
+void decodePngProgressive( ReaderBase &r, Reference &destination, const std::function<bool( unsigned pass )> &progress )
+{
+    PNGSignature sgntr;
+    makeException( sgntr.read( r ) );
+
+    PNGChunk ihdrChunk;
+    makeException( ihdrChunk.read( r ) );
+
+    PNGIHDRData ihdr;
+    makeException( ihdrChunk.meta.length == sizeof( ihdr ) && ihdrChunk.meta.is( "IHDR" ) );
+    copy( &ihdr, ihdrChunk.data.data(), sizeof( ihdr ) );
+
+    // Palette and transparency precede image data
+    PNGChunk chunk;
+    std::optional<PNGChunk> plte, trns;
+    while( true )
+    {
+        makeException( chunk.read( r ) && !chunk.meta.is( "IEND" ) );
+        if( chunk.meta.is( "IDAT" ) )
+        {
+            break;
+        }
+        else if( chunk.meta.is( "PLTE" ) )
+        {
+            makeException( !plte );
+            plte = std::move( chunk );
+        }
+        else if( chunk.meta.is( "tRNS" ) )
+        {
+            makeException( !trns );
+            trns = std::move( chunk );
+        }
+    }
+
+    Format fmt;
+    fmt.w = swapBe32( ihdr.width );
+    fmt.h = swapBe32( ihdr.height );
+    buildPng( fmt, ihdr, plte, trns );
+
+    // Filtering is done here, remaining layers are applied to every frame
+    auto filter = std::dynamic_pointer_cast<FilterAndInterlacePng>( fmt.compression.front() );
+    makeException( filter != nullptr );
+    fmt.compression.pop_front();
+    fmt.copy( *filter );
+
+    unsigned width = Abs( fmt.w );
+    unsigned height = Abs( fmt.h );
+    unsigned bits = fmt.bits;
+    size_t stride = fmt.lineSize();
+
+    // Pixels of completed rows are put at their places
+    Reference image;
+    image.fill();
+    sync( fmt, image );
+
+    std::vector<uint8_t> filtered( filter->size );
+
+    z_stream strm = {};
+    makeException( inflateInit( &strm ) == Z_OK );
+
+    Finalizer _;
+    _.push( [&strm]()
+    {
+        inflateEnd( &strm );
+    } );
+
+    strm.avail_out = filtered.size();
+    strm.next_out = filtered.data();
+
+    auto emit = [&]( unsigned pass )
+    {
+        auto blockW = FilterAndInterlacePng::passBlock[pass][0];
+        auto blockH = FilterAndInterlacePng::passBlock[pass][1];
+
+        Reference frame;
+        frame.fill();
+        sync( fmt, frame );
+
+        for( unsigned y = 0; y < height; ++y )
+        {
+            auto row = ( uint8_t * )frame.link + y * stride;
+            if( y % blockH != 0 )
+            {
+                copy( row, row - stride, stride );
+                continue;
+            }
+
+            const uint8_t *source = ( const uint8_t * )image.link + y * stride;
+            long long unsigned sourceBit = 0;
+            long long unsigned rowBit = 0;
+            BitList value = 0;
+            for( unsigned x = 0; x < width; ++x )
+            {
+                if( x % blockW == 0 )
+                {
+                    readBits( source, sourceBit, bits, value );
+                    if( blockW > 1 )
+                    {
+                        source += ( ( blockW - 1 ) * bits + sourceBit ) / 8;
+                        sourceBit = ( ( blockW - 1 ) * bits + sourceBit ) % 8;
+                    }
+                }
+                writeBits( row, rowBit, bits, value );
+            }
+        }
+
+        // Palette and transparency
+        Format frameFmt = fmt;
+        while( !frameFmt.compression.empty() )
+        {
+            auto layer = frameFmt.compression.front();
+
+            Reference next;
+            next.fill();
+            layer->decompress( frameFmt, frame, next );
+            frame = std::move( next );
+        }
+
+        // Raw images have lines padded to 4 bytes
+        Format rawFmt = frameFmt;
+        rawFmt.pad = 4;
+
+        Reference raw;
+        raw.fill();
+        sync( rawFmt, raw );
+        for( unsigned y = 0; y < height; ++y )
+            copy( ( uint8_t * )raw.link + y * rawFmt.lineSize(), ( const uint8_t * )frame.link + y * frameFmt.lineSize(), frameFmt.lineSize() );
+
+        std::string format;
+        for( const auto &channel : frameFmt.channels )
+            format += channel.channel + std::to_string( channel.bits );
+
+        raw.format = format;
+        raw.w = frameFmt.w;
+        raw.h = frameFmt.h;
+        translate( raw, destination, false );
+
+        return progress( pass + 1 );
+    };
+
+    // Passes are unfiltered as soon as their lines are inflated
+    unsigned pass = filter->interlaced ? 0 : 6, line = 0;
+    size_t consumed = 0;
+
+    auto drain = [&]()
+    {
+        auto produced = filtered.size() - strm.avail_out;
+        while( pass < 7 )
+        {
+            FilterAndInterlacePng::Step passStep( filter->interlaced ? pass : 0 );
+            FilterAndInterlacePng::Size passSize( width, height );
+            if( filter->interlaced )
+                passSize = FilterAndInterlacePng::Size( passStep, width, height );
+
+            if( !passSize.empty() )
+            {
+                auto bytes = passSize.lineBytes( bits );
+                while( line < passSize.number && consumed + bytes <= produced )
+                {
+                    // Previous line of the pass is already unfiltered right before this one
+                    auto data = filtered.data() + consumed;
+                    const uint8_t *previous = line > 0 ? data + 1 - bytes : nullptr;
+                    FilterAndInterlacePng::unfilterLine( data + 1, previous, bytes - 1, ( bits + 7 ) / 8, data[0] );
+
+                    const uint8_t *source = data + 1;
+                    long long unsigned sourceBit = 0;
+                    auto y = filter->interlaced ? passStep.y( line ) : line;
+                    for( unsigned px = 0; px < passSize.scanline; ++px )
+                    {
+                        BitList value;
+                        readBits( source, sourceBit, bits, value );
+
+                        auto x = filter->interlaced ? passStep.x( px ) : px;
+                        auto target = ( uint8_t * )image.link + y * stride + x * bits / 8;
+                        long long unsigned targetBit = x * bits % 8;
+                        writeBits( target, targetBit, bits, value );
+                    }
+
+                    consumed += bytes;
+                    ++line;
+                }
+
+                if( line < passSize.number )
+                    return true;
+
+                if( !emit( pass ) )
+                    return false;
+            }
+
+            line = 0;
+            ++pass;
+        }
+        return true;
+    };
+
+    do
+    {
+        if( !chunk.meta.is( "IDAT" ) )
+            continue;
+
+        strm.avail_in = chunk.data.size();
+        strm.next_in = chunk.data.data();
+        while( strm.avail_in > 0 )
+        {
+            auto result = inflate( &strm, Z_NO_FLUSH );
+            if( result == Z_STREAM_END )
+                break;
+            makeException( result == Z_OK );
+        }
+
+        if( !drain() )
+            return;
+    }
+    while( pass < 7 && chunk.read( r ) );
+
+    makeException( pass == 7 );
+}
 }
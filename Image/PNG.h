@@ -26,7 +26,7 @@ struct PNGSignature
 
 struct FracturePng : public Compression
 {
-    FracturePng( unsigned s, const PixelFormat &pfmt );
+    FracturePng( size_t s, const PixelFormat &pfmt );
 
     void compress( Format &fmt, const Reference &source, Reference &destination ) override;
     void decompress( Format &fmt, const Reference &source, Reference &destination ) const override;
@@ -36,7 +36,7 @@ struct FracturePng : public Compression
 
 struct ZlibPng : public Compression
 {
-    ZlibPng( unsigned s, const PixelFormat &pfmt );
+    ZlibPng( size_t s, const PixelFormat &pfmt );
 
     void compress( Format &fmt, const Reference &source, Reference &destination ) override;
     void decompress( Format &fmt, const Reference &source, Reference &destination ) const override;
@@ -57,6 +57,12 @@ struct FilterAndInterlacePng : public Compression
         {8, 8}, {8, 8}, {4, 8}, {4, 4}, {2, 4}, {2, 2}, {1, 2}
     };
 
+    // Size of blocks, that are covered by a single pixel, when passes up to current one are decoded
+    static constexpr unsigned passBlock[7][2] =
+    {
+        {8, 8}, {4, 8}, {4, 4}, {2, 4}, {2, 2}, {1, 2}, {1, 1}
+    };
+
     struct Step
     {
         unsigned startX, startY, incX, incY;
@@ -74,8 +80,8 @@ struct FilterAndInterlacePng : public Compression
         Size( unsigned w, unsigned h );
         Size( const Step &step, unsigned w, unsigned h );
 
-        unsigned lineBytes( unsigned bits ) const;
-        unsigned bytes( unsigned bits ) const;
+        size_t lineBytes( unsigned bits ) const;
+        size_t bytes( unsigned bits ) const;
         bool empty() const;
     };
 
@@ -86,6 +92,11 @@ struct FilterAndInterlacePng : public Compression
     static unsigned scoreCandidate( const std::vector<BitList> &candidate );
     std::vector<BitList> applyFilter( const std::vector<BitList> &line, const std::vector<BitList> &previous, unsigned filterType, bool apply ) const;
 
+    // Kernels for whole-byte pixels, 'previous' is nullptr for the first line of a pass
+    // Filters work on bytes, so 16-bit samples are handled as pairs of bytes, that are 'pixelBytes' apart from neighbours
+    static void unfilterLine( uint8_t *line, const uint8_t *previous, size_t bytes, unsigned pixelBytes, unsigned filterType );
+    static void filterLine( const uint8_t *line, const uint8_t *previous, uint8_t *result, size_t bytes, unsigned pixelBytes, unsigned filterType );
+
     FilterAndInterlacePng( bool interlaced, int w, int h, const PixelFormat &pfmt );
     FilterAndInterlacePng( const FilterAndInterlacePng &other );
 
@@ -94,8 +105,20 @@ struct FilterAndInterlacePng : public Compression
     void compress( Format &fmt, const Reference &source, Reference &destination ) override;
     void decompress( Format &fmt, const Reference &source, Reference &destination ) const override;
 
+    // Paths for whole-byte pixels, they work with bytes directly instead of pixel readers and writers
+    void compressBytes( Format &fmt, const Reference &source, Reference &destination );
+    void decompressBytes( Format &fmt, const Reference &source, Reference &destination ) const;
+
     bool equals( const Compression &other ) const override;
 };
 
-void makePng( const Reference &ref, Format &format, HeaderWriter *write );
+// Images are written with 8 or 16 bits per channel, 'depth' is used only for writing
+void makePng( const Reference &ref, Format &format, HeaderWriter *write, unsigned depth = 8 );
+
+// Decodes png file, that is read chunk by chunk from 'r', into 'destination' as translate( source, destination, false ) would
+// Image data is inflated and unfiltered as chunks arrive, so early passes are shown before the rest of the file is read
+// After each Adam7 pass 'destination' holds whole image, where missing pixels repeat nearest decoded ones to the upper left
+// Then 'progress' receives number of completed pass from 1 to 7, returning false stops decoding
+// Images without interlacing are reported once as pass 7
+void decodePngProgressive( ReaderBase &r, Reference &destination, const std::function<bool( unsigned pass )> &progress );
 }
@@ -0,0 +1,319 @@
+#include "Image/QOI.h"
+
+#include <limits>
+
+namespace ImageConvert
+{
+#define QOI_OP_INDEX 0x00
+#define QOI_OP_DIFF 0x40
+#define QOI_OP_LUMA 0x80
+#define QOI_OP_RUN 0xc0
+#define QOI_OP_RGB 0xfe
+#define QOI_OP_RGBA 0xff
+
+#define QOI_MASK 0xc0
+
+static const uint8_t qoiEnd[8] = {0, 0, 0, 0, 0, 0, 0, 1};
+
+struct QOIPixel
+{
+    uint8_t r, g, b, a;
+
+    unsigned hash() const
+    {
+        return ( r * 3 + g * 5 + b * 7 + a * 11 ) % 64;
+    }
+
+    bool operator==( const QOIPixel &other ) const
+    {
+        return r == other.r && g == other.g && b == other.b && a == other.a;
+    }
+
+    bool operator!=( const QOIPixel &other ) const
+    {
+        return !( *this == other );
+    }
+};
+
+ChunksQoi::ChunksQoi( size_t s, const PixelFormat &pfmt ) : Compression( s, pfmt )
+{}
+
+void ChunksQoi::compress( Format &fmt, const Reference &source, Reference &destination )
+{
+    makeException( fmt.compression.front().get() == this );
+    makeException( this->PixelFormat::operator==( fmt ) );
+
+    size_t depth = channels.size();
+    makeException( ( depth == 3 || depth == 4 ) && fmt.bits == depth * 8 );
+
+    unsigned width = Abs( fmt.w );
+    unsigned height = Abs( fmt.h );
+    size_t lineBytes = fmt.lineSize();
+    makeException( source.bytes >= fmt.bufferSize( this ) );
+
+    // Chunks are always written from top to bottom and from left to right
+    bool flipX = fmt.w < 0;
+    bool flipY = fmt.h < 0;
+    auto input = ( const uint8_t * )source.link + fmt.offset;
+
+    fmt.offset = 0;
+    fmt.clear();
+
+    // Worst case is a tag byte for every pixel on top of its channels
+    size = sizeSum( sizeProduct( sizeProduct( width, height ), depth + 1 ), sizeof( qoiEnd ) );
+    sync( fmt, destination );
+
+    auto output = ( uint8_t * )destination.link;
+    auto p = output;
+
+    QOIPixel index[64] = {}, previous{0, 0, 0, 255}, pixel = previous;
+    unsigned run = 0;
+
+    for( unsigned y = 0; y < height; ++y )
+    {
+        auto line = input + ( flipY ? height - 1 - y : y ) * lineBytes;
+        for( unsigned x = 0; x < width; ++x )
+        {
+            auto c = line + ( flipX ? width - 1 - x : x ) * depth;
+            pixel.r = c[0];
+            pixel.g = c[1];
+            pixel.b = c[2];
+            if( depth == 4 )
+                pixel.a = c[3];
+
+            if( pixel == previous )
+            {
+                if( ++run == 62 )
+                {
+                    *p++ = QOI_OP_RUN | ( run - 1 );
+                    run = 0;
+                }
+                continue;
+            }
+
+            if( run > 0 )
+            {
+                *p++ = QOI_OP_RUN | ( run - 1 );
+                run = 0;
+            }
+
+            auto &indexed = index[pixel.hash()];
+            if( indexed == pixel )
+            {
+                *p++ = QOI_OP_INDEX | pixel.hash();
+            }
+            else if( pixel.a == previous.a )
+            {
+                indexed = pixel;
+
+                int8_t dr = pixel.r - previous.r;
+                int8_t dg = pixel.g - previous.g;
+                int8_t db = pixel.b - previous.b;
+                int8_t drg = dr - dg;
+                int8_t dbg = db - dg;
+
+                if( -2 <= dr && dr <= 1 && -2 <= dg && dg <= 1 && -2 <= db && db <= 1 )
+                {
+                    *p++ = QOI_OP_DIFF | ( dr + 2 ) << 4 | ( dg + 2 ) << 2 | ( db + 2 );
+                }
+                else if( -32 <= dg && dg <= 31 && -8 <= drg && drg <= 7 && -8 <= dbg && dbg <= 7 )
+                {
+                    *p++ = QOI_OP_LUMA | ( dg + 32 );
+                    *p++ = ( drg + 8 ) << 4 | ( dbg + 8 );
+                }
+                else
+                {
+                    *p++ = QOI_OP_RGB;
+                    *p++ = pixel.r;
+                    *p++ = pixel.g;
+                    *p++ = pixel.b;
+                }
+            }
+            else
+            {
+                indexed = pixel;
+
+                *p++ = QOI_OP_RGBA;
+                *p++ = pixel.r;
+                *p++ = pixel.g;
+                *p++ = pixel.b;
+                *p++ = pixel.a;
+            }
+
+            previous = pixel;
+        }
+    }
+
+    if( run > 0 )
+        *p++ = QOI_OP_RUN | ( run - 1 );
+
+    ::copy( p, qoiEnd, sizeof( qoiEnd ) );
+    p += sizeof( qoiEnd );
+
+    // Buffer only shrinks here, so it's not reallocated
+    size = p - output;
+    sync( fmt, destination );
+
+    fmt.w = Abs( fmt.w );
+    fmt.h = Abs( fmt.h );
+}
+
+void ChunksQoi::decompress( Format &fmt, const Reference &source, Reference &destination ) const
+{
+    makeException( fmt.compression.front().get() == this );
+    makeException( source.bytes >= fmt.offset );
+
+    auto p = ( const uint8_t * )source.link + fmt.offset;
+    auto end = p + ( source.bytes - fmt.offset );
+
+    fmt.offset = 0;
+    fmt.compression.pop_front();
+    fmt.copy( *this );
+    sync( fmt, destination );
+
+    unsigned depth = channels.size();
+    makeException( ( depth == 3 || depth == 4 ) && bits == depth * 8 );
+
+    unsigned width = Abs( fmt.w );
+    unsigned height = Abs( fmt.h );
+    size_t lineBytes = fmt.lineSize();
+    auto output = ( uint8_t * )destination.link;
+
+    QOIPixel index[64] = {}, pixel{0, 0, 0, 255};
+    unsigned run = 0;
+
+    for( unsigned y = 0; y < height; ++y )
+    {
+        auto c = output + y * lineBytes;
+        for( unsigned x = 0; x < width; ++x, c += depth )
+        {
+            if( run > 0 )
+            {
+                --run;
+            }
+            else
+            {
+                // Longest chunk takes 5 bytes, stream always ends with 8 bytes marker
+                makeException( end - p >= 5 );
+
+                uint8_t tag = *p++;
+                if( tag == QOI_OP_RGB )
+                {
+                    pixel.r = *p++;
+                    pixel.g = *p++;
+                    pixel.b = *p++;
+                }
+                else if( tag == QOI_OP_RGBA )
+                {
+                    pixel.r = *p++;
+                    pixel.g = *p++;
+                    pixel.b = *p++;
+                    pixel.a = *p++;
+                }
+                else if( ( tag & QOI_MASK ) == QOI_OP_INDEX )
+                {
+                    pixel = index[tag];
+                }
+                else if( ( tag & QOI_MASK ) == QOI_OP_DIFF )
+                {
+                    pixel.r += ( ( tag >> 4 ) & 0x03 ) - 2;
+                    pixel.g += ( ( tag >> 2 ) & 0x03 ) - 2;
+                    pixel.b += ( tag & 0x03 ) - 2;
+                }
+                else if( ( tag & QOI_MASK ) == QOI_OP_LUMA )
+                {
+                    uint8_t next = *p++;
+                    int dg = ( tag & 0x3f ) - 32;
+                    pixel.r += dg - 8 + ( ( next >> 4 ) & 0x0f );
+                    pixel.g += dg;
+                    pixel.b += dg - 8 + ( next & 0x0f );
+                }
+                else
+                {
+                    run = tag & 0x3f;
+                }
+
+                index[pixel.hash()] = pixel;
+            }
+
+            c[0] = pixel.r;
+            c[1] = pixel.g;
+            c[2] = pixel.b;
+            if( depth == 4 )
+                c[3] = pixel.a;
+        }
+    }
+}
+
+bool ChunksQoi::equals( const Compression &other ) const
+{
+    if( dynamic_cast<const ChunksQoi *>( &other ) )
+        return this->Compression::operator==( other );
+    return false;
+};
+
+static void extractQoi( Format &fmt, ReaderBase &r, size_t bytes )
+{
+    QOIHeader header, sample;
+    makeException( r.read( sizeof( header ), &header ) );
+    makeException( compare( header.magic, sample.magic, sizeof( sample.magic ) ) );
+
+    // Header is untrusted, sizes must fit into int and buffer size must not overflow
+    uint32_t width = swapBe32( header.width );
+    uint32_t height = swapBe32( header.height );
+    makeException( width > 0 && width <= uint32_t( std::numeric_limits<int>::max() ) );
+    makeException( height > 0 && height <= uint32_t( std::numeric_limits<int>::max() ) );
+    makeException( header.channels == 3 || header.channels == 4 );
+    sizeProduct( sizeProduct( width, height ), header.channels );
+
+    fmt.clear();
+    fmt.w = width;
+    fmt.h = height;
+    fmt.offset = sizeof( header );
+
+    fmt.channels.push_back( { 'R', 8 } );
+    fmt.channels.push_back( { 'G', 8 } );
+    fmt.channels.push_back( { 'B', 8 } );
+    if( header.channels == 4 )
+        fmt.channels.push_back( { 'A', 8 } );
+    fmt.calculateBits();
+
+    fmt.compression.push_front( std::make_shared<ChunksQoi>( bytes - fmt.offset, fmt ) );
+    fmt.clear();
+}
+
+void makeQoi( const Reference &ref, Format &format, HeaderWriter *write )
+{
+    format.w = ref.w;
+    format.h = ref.h;
+
+    if( !write )
+    {
+        SimpleReader r( ref.link, ref.bytes );
+        extractQoi( format, r, ref.bytes );
+        return;
+    }
+
+    format.offset += sizeof( QOIHeader );
+    format.channels.push_back( { 'R', 8 } );
+    format.channels.push_back( { 'G', 8 } );
+    format.channels.push_back( { 'B', 8 } );
+    format.channels.push_back( { 'A', 8 } );
+    format.calculateBits();
+
+    format.compression.push_front( std::make_shared<ChunksQoi>( 0, format ) );
+    format.clear();
+
+    *write = []( const Format & fmt, Reference & dst )
+    {
+        SimpleWriter w( dst.link, dst.bytes );
+
+        QOIHeader header;
+        header.width = swapBe32( Abs( fmt.w ) );
+        header.height = swapBe32( Abs( fmt.h ) );
+        header.channels = 4;
+        header.colorspace = 0;
+        makeException( w.write( sizeof( header ), &header ) );
+    };
+}
+}
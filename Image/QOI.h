@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+
+#include "Image/Format.h"
+#include "Image/ANYF.h"
+
+#include "BitIO.h"
+
+// https://qoiformat.org/qoi-specification.pdf
+
+namespace ImageConvert
+{
+// (File) header <-> chunks (Pixels)
+
+// Ensure structures are packed without padding
+#pragma pack(push, 1)
+
+// 14 bytes at the very start of the file
+struct QOIHeader
+{
+    char magic[4] {'q', 'o', 'i', 'f'};
+    uint32_t width;     // Image width in pixels (big-endian)
+    uint32_t height;    // Image height in pixels (big-endian)
+    uint8_t channels;   // 3 = RGB, 4 = RGBA
+    uint8_t colorspace; // 0 = sRGB with linear alpha, 1 = all channels linear
+};
+
+#pragma pack(pop)
+
+// Codes R8G8B8 or R8G8B8A8 pixels into chunks, followed by end marker
+// Works with bytes directly, so it runs at memory speed, there is no entropy coding
+struct ChunksQoi : public Compression
+{
+    ChunksQoi( size_t s, const PixelFormat &pfmt );
+
+    void compress( Format &fmt, const Reference &source, Reference &destination ) override;
+    void decompress( Format &fmt, const Reference &source, Reference &destination ) const override;
+
+    bool equals( const Compression &other ) const override;
+};
+
+void makeQoi( const Reference &ref, Format &format, HeaderWriter *write );
+}
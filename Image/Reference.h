@@ -2,6 +2,7 @@
 
 #include <functional>
 #include <optional>
+#include <cstddef>
 #include <string>
 
 namespace ImageConvert
@@ -29,13 +30,14 @@ public:
     // When format is added first bytes at 'source.link'/'destination.link' should have header(s) before/after reading/writing
     // '.BMP' to process data of 'bmp' files
     // '.DIB' same as 'bmp', but does not contain file header
-    // '.PNG' to process data of 'png' files
+    // '.PNG' to process data of 'png' files, written with 16 bits per channel, if source has deeper channels than 8 bits
     // '.JPG' to process data of 'jpg' files
+    // '.QOI' to process data of 'qoi' files, fast lossless format for intermediate images
     // '.ANYF' program will make a guess, when reading, and use default format for writing. Only works for file contents
     std::optional<std::string> format;
 
     // Number of bytes stored at the address
-    unsigned bytes;
+    size_t bytes;
 
     // Pointer to data
     void *link;
@@ -10,8 +10,10 @@
 #include "Image/BMP.h"
 #include "Image/PNG.h"
 #include "Image/JPG.h"
+#include "Image/QOI.h"
 
 #include "Exception.h"
+#include "Parallel.h"
 #include "Basic.h"
 
 namespace ImageConvert
@@ -43,6 +45,22 @@ static inline unsigned getNumber( const std::string &string, size_t &i )
     return result;
 }
 
+// Largest depth of color and alpha channels of decoded pixels
+static unsigned formatDepth( const Format &fmt )
+{
+    const PixelFormat *pixels = &fmt;
+    if( !fmt.compression.empty() )
+        pixels = fmt.compression.back().get();
+
+    unsigned depth = 0;
+    for( const auto &channel : pixels->channels )
+    {
+        if( channel.channel != '_' && channel.channel != '#' )
+            depth = Max( depth, channel.bits );
+    }
+    return depth;
+}
+
 static Format parseFormat( const Reference &ref, HeaderWriter *write, const Format *sample )
 {
     const static std::vector<std::string> types
@@ -51,7 +69,8 @@ static Format parseFormat( const Reference &ref, HeaderWriter *write, const Form
         "BMP",
         "PNG",
         "JPG",
-        "ANYF"
+        "ANYF",
+        "QOI"
     };
 
     const static std::vector<std::string> settings
@@ -135,6 +154,9 @@ static Format parseFormat( const Reference &ref, HeaderWriter *write, const Form
         format.channels.push_back( { channel, bits } );
     }
 
+    // Sources with deeper channels are written into 16-bit png files, so precision isn't lost
+    unsigned pngDepth = sample && formatDepth( *sample ) > 8 ? 16 : 8;
+
     switch( typeId )
     {
     case 0:
@@ -150,7 +172,7 @@ static Format parseFormat( const Reference &ref, HeaderWriter *write, const Form
         break;
     case 3:
         format.clear();
-        makePng( ref, format, write );
+        makePng( ref, format, write, pngDepth );
         break;
     case 4:
         format.clear();
@@ -162,6 +184,7 @@ static Format parseFormat( const Reference &ref, HeaderWriter *write, const Form
         {
             uint8_t jpgMarker[2] = {0xFF, 0xD8};
             char bmpMarker[2] = {'B', 'M'};
+            QOIHeader qoiHeader;
 
             makeException( ref.bytes >= 16 );
 
@@ -173,6 +196,10 @@ static Format parseFormat( const Reference &ref, HeaderWriter *write, const Form
             {
                 makeBmp( ref, true, true, format, write );
             }
+            else if( compare( ref.link, qoiHeader.magic, sizeof( qoiHeader.magic ) ) )
+            {
+                makeQoi( ref, format, write );
+            }
             else
             {
                 PNGSignature ps;
@@ -182,9 +209,13 @@ static Format parseFormat( const Reference &ref, HeaderWriter *write, const Form
         }
         else
         {
-            makePng( ref, format, write );
+            makePng( ref, format, write, pngDepth );
         }
         break;
+    case 6:
+        format.clear();
+        makeQoi( ref, format, write );
+        break;
     default:
         makeException( false );
     }
@@ -219,6 +250,177 @@ static void copyTranslate( const Format &srcFmt, const Reference &source, Format
     }
 }
 
+// Channel of destination for formats with whole byte channels, see 'bytesTranslate'
+struct ByteChannel
+{
+    enum Kind
+    {
+        Constant,
+        Copy8,
+        Copy16,
+        Narrow,
+        Widen
+    };
+
+    Kind kind;
+
+    // Byte offsets in source and destination pixels
+    unsigned srcOffset, dstOffset;
+
+    // Value of a constant channel in big-endian order, 1 or 2 bytes are used
+    uint8_t constant[2];
+};
+
+// Channels of 8 and 16 bits are aligned to bytes, so pixels can be converted without readers and writers
+static bool wholeBytes( const PixelFormat &fmt )
+{
+    for( auto &channel : fmt.channels )
+    {
+        if( channel.bits != 8 && channel.bits != 16 )
+            return false;
+    }
+    return !fmt.channels.empty();
+}
+
+// Same mapping of channels, as 'convert' does, but prepared once for all pixels
+static std::vector<ByteChannel> planBytes( const PixelFormat &srcFmt, const PixelFormat &dstFmt )
+{
+    std::vector<unsigned> srcOffsets;
+    unsigned offset = 0;
+    for( auto &channel : srcFmt.channels )
+    {
+        srcOffsets.push_back( offset );
+        offset += channel.bits / 8;
+    }
+
+    std::vector<ByteChannel> plan;
+    offset = 0;
+    for( unsigned dstId = 0; dstId < dstFmt.channels.size(); ++dstId )
+    {
+        auto &dstChannel = dstFmt.channels[dstId];
+
+        ByteChannel channel;
+        channel.kind = ByteChannel::Constant;
+        channel.srcOffset = 0;
+        channel.dstOffset = offset;
+        channel.constant[0] = channel.constant[1] = 0;
+        offset += dstChannel.bits / 8;
+
+        std::optional<unsigned> srcId;
+        if( dstChannel.channel != '_' )
+        {
+            srcId = srcFmt.id( dstChannel.channel );
+            if( !srcId )
+            {
+                auto replacement = dstFmt.replace( dstId, srcFmt, srcId );
+                if( !srcId )
+                {
+                    makeException( replacement && replacement->constant );
+                    auto value = *replacement->constant & dstChannel.max();
+                    if( dstChannel.bits == 16 )
+                    {
+                        channel.constant[0] = uint8_t( value >> 8 );
+                        channel.constant[1] = uint8_t( value );
+                    }
+                    else
+                    {
+                        channel.constant[0] = uint8_t( value );
+                    }
+                }
+            }
+        }
+
+        if( srcId )
+        {
+            auto srcBits = srcFmt.channels[*srcId].bits;
+            channel.srcOffset = srcOffsets[*srcId];
+            if( srcBits == dstChannel.bits )
+                channel.kind = srcBits == 8 ? ByteChannel::Copy8 : ByteChannel::Copy16;
+            else
+                channel.kind = srcBits == 16 ? ByteChannel::Narrow : ByteChannel::Widen;
+        }
+        else if( dstChannel.bits == 16 )
+        {
+            // 16-bit constants are written by two byte entries
+            channel.kind = ByteChannel::Constant;
+            plan.push_back( channel );
+            channel.dstOffset += 1;
+            channel.constant[0] = channel.constant[1];
+        }
+
+        plan.push_back( channel );
+    }
+    return plan;
+}
+
+// Converts pixels of formats, that have only whole byte channels, line by line on several threads
+// 16-bit values are big-endian, they are narrowed and widened with the same tables, as 'rescale' uses
+static void bytesTranslate( const Format &srcFmt, const Reference &source, const Format &dstFmt, Reference &destination, bool flipX, bool flipY )
+{
+    size_t width = Abs( srcFmt.w );
+    size_t height = Abs( srcFmt.h );
+    size_t srcStride = srcFmt.lineSize(), dstStride = dstFmt.lineSize();
+    unsigned srcPixel = srcFmt.bits / 8, dstPixel = dstFmt.bits / 8;
+
+    makeException( source.bytes >= sizeSum( srcFmt.offset, sizeProduct( height, srcStride ) ) );
+    makeException( destination.bytes >= sizeSum( dstFmt.offset, sizeProduct( height, dstStride ) ) );
+
+    auto plan = planBytes( srcFmt, dstFmt );
+    auto narrow = depthTable( 16, 8 );
+    auto widen = depthTable( 8, 16 );
+
+    auto input = ( const uint8_t * )source.link + srcFmt.offset;
+    auto output = ( uint8_t * )destination.link + dstFmt.offset;
+
+    parallelFor( height, [&]( size_t begin, size_t end )
+    {
+        for( size_t y = begin; y < end; ++y )
+        {
+            auto src = input + ( flipY ? height - 1 - y : y ) * srcStride;
+            auto dst = output + y * dstStride;
+
+            ptrdiff_t step = srcPixel;
+            if( flipX )
+            {
+                src += ( width - 1 ) * srcPixel;
+                step = -step;
+            }
+
+            for( size_t x = 0; x < width; ++x, src += step, dst += dstPixel )
+            {
+                for( auto &channel : plan )
+                {
+                    auto s = src + channel.srcOffset;
+                    auto d = dst + channel.dstOffset;
+                    switch( channel.kind )
+                    {
+                    case ByteChannel::Constant:
+                        d[0] = channel.constant[0];
+                        break;
+                    case ByteChannel::Copy8:
+                        d[0] = s[0];
+                        break;
+                    case ByteChannel::Copy16:
+                        d[0] = s[0];
+                        d[1] = s[1];
+                        break;
+                    case ByteChannel::Narrow:
+                        d[0] = uint8_t( narrow[( s[0] << 8 ) | s[1]] );
+                        break;
+                    case ByteChannel::Widen:
+                        d[0] = uint8_t( widen[s[0]] >> 8 );
+                        d[1] = uint8_t( widen[s[0]] );
+                        break;
+                    }
+                }
+            }
+
+            // Padding is zero, as writers leave it
+            ::clear( dst, output + ( y + 1 ) * dstStride - dst );
+        }
+    }, 16 );
+}
+
 // Performs a per–pixel conversion when the source and destination have the same dimensions
 // With flipping image, if signs of dimensions change between images
 // Matching channels with different bit sizes will be first normalized
@@ -236,18 +438,6 @@ static void directTranslate( const Format &srcFmt, const Reference &source, Form
     int width  = Abs( srcFmt.w );
     int height = Abs( srcFmt.h );
 
-    // Read the entire source image into a temporary buffer
-    std::vector<Pixel> srcPixels( width * height );
-
-    PixelReader sourcePixelReader( srcFmt, source );
-    for( int y = 0; y < height; ++y )
-    {
-        for( int x = 0; x < width; ++x )
-        {
-            makeException( sourcePixelReader.getPixelLn( srcPixels[y * width + x] ) );
-        }
-    }
-
     // Determine whether we need to flip in each direction
     bool flipX = ( ( srcFmt.w < 0 ) ^ ( dstFmt.w < 0 ) );
     bool flipY = ( ( srcFmt.h < 0 ) ^ ( dstFmt.h < 0 ) );
@@ -259,6 +449,26 @@ static void directTranslate( const Format &srcFmt, const Reference &source, Form
         flipX = false;
         flipY = false;
     }
+
+    if( wholeBytes( srcFmt ) && wholeBytes( dstFmt ) )
+    {
+        sync( dstFmt, destination );
+        bytesTranslate( srcFmt, source, dstFmt, destination, flipX, flipY );
+        return;
+    }
+
+    // Read the entire source image into a temporary buffer
+    std::vector<Pixel> srcPixels( sizeProduct( width, height ) );
+
+    PixelReader sourcePixelReader( srcFmt, source );
+    for( int y = 0; y < height; ++y )
+    {
+        for( int x = 0; x < width; ++x )
+        {
+            makeException( sourcePixelReader.getPixelLn( srcPixels[size_t( y ) * width + x] ) );
+        }
+    }
+
     sync( dstFmt, destination );
 
     PixelWriter destinationPixelWriter( dstFmt, destination );
@@ -269,7 +479,7 @@ static void directTranslate( const Format &srcFmt, const Reference &source, Form
             int srcX = flipX ? ( width - 1 - x ) : x;
             int srcY = flipY ? ( height - 1 - y ) : y;
 
-            auto &srcPixel = srcPixels[srcY * width + srcX];
+            auto &srcPixel = srcPixels[size_t( srcY ) * width + srcX];
             auto dstPixel = convert<Pixel, Pixel>( srcPixel, srcFmt, dstFmt );
             makeException( destinationPixelWriter.putPixelLn( dstPixel ) );
         }
@@ -302,7 +512,7 @@ static void scaleTranslate( const Format &srcFmt, const Reference &source, Forma
     bool flipY = ( ( srcFmt.h < 0 ) ^ ( dstFmt.h < 0 ) );
 
     // Read the entire source image into a temporary buffer
-    std::vector<Color> srcColors( srcWidth * srcHeight );
+    std::vector<Color> srcColors( sizeProduct( srcWidth, srcHeight ) );
     PixelReader sourcePixelReader( srcFmt, source );
     Pixel pixel;
     for( int y = 0; y < srcHeight; ++y )
@@ -310,7 +520,7 @@ static void scaleTranslate( const Format &srcFmt, const Reference &source, Forma
         for( int x = 0; x < srcWidth; ++x )
         {
             makeException( sourcePixelReader.getPixelLn( pixel ) );
-            srcColors[y * srcWidth + x] = convert<Pixel, Color>( pixel, srcFmt, srcFmt );
+            srcColors[size_t( y ) * srcWidth + x] = convert<Pixel, Color>( pixel, srcFmt, srcFmt );
         }
     }
 
@@ -368,7 +578,7 @@ static void scaleTranslate( const Format &srcFmt, const Reference &source, Forma
 
                     // Retrieve the source pixel color
                     // Convert it to the destination color space
-                    Color dstColor = convert<Color, Color>( srcColors[ sy * srcWidth + sx ], srcFmt, dstFmt );
+                    Color dstColor = convert<Color, Color>( srcColors[size_t( sy ) * srcWidth + sx], srcFmt, dstFmt );
                     for( size_t i = 0; i < dstColor.size(); ++i )
                     {
                         auto alpha = alphaId && alphaId != i ? dstColor[*alphaId] : 1;
@@ -401,6 +611,11 @@ static void scaleTranslate( const Format &srcFmt, const Reference &source, Forma
 // Translate
 // ---------------------------------------------------------------------------
 
+unsigned channelDepth( const Reference &image )
+{
+    return formatDepth( parseFormat( image, nullptr, nullptr ) );
+}
+
 void translate( const Reference &source, Reference &destination, bool scale )
 {
     makeException( source.format.has_value() && source.link && destination.reset );
@@ -471,4 +686,24 @@ void translate( const Reference &source, Reference &destination, bool scale )
     copyTranslate( resultFmt, result, dstFmt, destination );
     write( dstFmt, destination );
 }
+
+Reference unpackRgba( const Reference &image, bool deep )
+{
+    Reference result;
+    result.fill();
+    result.format = deep ? "R16G16B16A16*REPA65535" : "R8G8B8A8*REPA255";
+    translate( image, result, false );
+
+    if( result.w >= 0 && result.h >= 0 )
+        return result;
+
+    // Scaling to the same size only fixes orientation
+    Reference flipped;
+    flipped.fill();
+    flipped.format = result.format;
+    flipped.w = Abs( result.w );
+    flipped.h = Abs( result.h );
+    translate( result, flipped, true );
+    return flipped;
+}
 }
@@ -8,4 +8,11 @@ namespace ImageConvert
 // Conversion occurs in normalized space (each channel is in [0,1])
 // Uses areaweighted scaling
 void translate( const Reference &source, Reference &destination, bool scale );
+
+// Returns largest bit-width of channels, that are stored in the image after all decompression steps
+// Unused channels and palette indices are not counted
+unsigned channelDepth( const Reference &image );
+
+// Translates image into top-down R8G8B8A8 or R16G16B16A16, if 'deep', missing alpha is opaque
+Reference unpackRgba( const Reference &image, bool deep );
 }
@@ -2,9 +2,16 @@
 
 #include <functional>
 
+#include "Parallel.h"
 #include "Buffer.h"
 #include "Basic.h"
 
+// Values, that one thread gets at least, when matrix is transformed on several threads
+#define MATRIX_GRANULE 65536
+
+// Side of square tiles of tiled transform
+#define MATRIX_TILE 64
+
 template<typename T>
 class MatrixBase
 {
@@ -12,6 +19,19 @@ private:
     int width, height, stride;
     Buffer<T> data;
     T *pointer;
+
+    // Calls 'f' for values of lines [first, last) and columns [left, right), line after line
+    template<typename D, typename F>
+    void transformBlock( MatrixBase<D> &out, F &f, int first, int last, int left, int right ) const
+    {
+        for( int i = first; i < last; ++i )
+        {
+            const T *input = ( *this )( 0, i );
+            D *output = out( 0, i );
+            for( int j = left; j < right; ++j )
+                f( width, height, j, i, input[j], output[j] );
+        }
+    }
 public:
     MatrixBase()
     {
@@ -410,24 +430,48 @@ public:
         }
     }
 
-    template<typename D>
-    void transform( MatrixBase<D> &out, const std::function<void( int, int, int, int, const T &, D & )> &f ) const
+    // Calls f( width, height, j, i, value, result ) for every value of this matrix and value of 'out' at the same position
+    // 'f' is any callable and is called directly, so compilers inline it and vectorize loops over lines
+    // 'out' gets the size of this matrix, it may be this matrix, values are traversed line after line
+    template<typename D, typename F>
+    void transform( MatrixBase<D> &out, F &&f ) const
     {
-        const T *input;
-        D *output;
-        int i, j;
+        if( ( out.w() != width ) || ( out.h() != height ) )
+            out.reset( width, height );
+
+        transformBlock( out, f, 0, height, 0, width );
+    }
 
+    // Same as transform, but lines are split between threads, so 'f' must be safe to call from several threads at once
+    template<typename D, typename F>
+    void transformParallel( MatrixBase<D> &out, F &&f ) const
+    {
         if( ( out.w() != width ) || ( out.h() != height ) )
             out.reset( width, height );
 
-        for( j = 0; j < width; ++j )
+        parallelFor( height, [&]( size_t begin, size_t end )
         {
-            for( i = 0; i < height; ++i )
+            transformBlock( out, f, begin, end, 0, width );
+        }, Max( MATRIX_GRANULE / Max( width, 1 ), 1 ) );
+    }
+
+    // Same as transformParallel, but values are traversed by square tiles, lines of tiles are split between threads
+    // Suits functions, that also read other matrices around position ( j, i ) or across lines, like rotations
+    template<typename D, typename F>
+    void transformTiled( MatrixBase<D> &out, F &&f ) const
+    {
+        if( ( out.w() != width ) || ( out.h() != height ) )
+            out.reset( width, height );
+
+        int tiles = ( height + MATRIX_TILE - 1 ) / MATRIX_TILE;
+        parallelFor( tiles, [&]( size_t begin, size_t end )
+        {
+            int last = Min( int( end ) * MATRIX_TILE, height );
+            for( int top = begin * MATRIX_TILE; top < last; top += MATRIX_TILE )
             {
-                input = ( *this )( j, i );
-                output = out( j, i );
-                f( width, height, j, i, *input, *output );
+                for( int left = 0; left < width; left += MATRIX_TILE )
+                    transformBlock( out, f, top, Min( top + MATRIX_TILE, height ), left, Min( left + MATRIX_TILE, width ) );
             }
-        }
+        }, Max( MATRIX_GRANULE / Max( width * MATRIX_TILE, 1 ), 1 ) );
     }
 };
@@ -1,6 +1,8 @@
 #pragma once
 
+#include "Exception.h"
 #include "Vector2D.h"
+#include "Basic.h"
 
 class Matrix2D
 {
@@ -10,43 +12,233 @@ public:
     double a00, a01,
            a10, a11;
 
-    Matrix2D();
-    Matrix2D( double a00, double a01, double a10, double a11 );
-    Matrix2D( const Matrix2D& other );
+    constexpr Matrix2D();
+    constexpr Matrix2D( double a00, double a01, double a10, double a11 );
+    Matrix2D( const Matrix2D& other ) = default;
 
-    Matrix2D& operator=( const Matrix2D& other );
+    Matrix2D& operator=( const Matrix2D& other ) = default;
 
-    Matrix2D operator*( const Matrix2D &a ) const;
-    Matrix2D &operator*=( const Matrix2D &a );
+    constexpr Matrix2D operator*( const Matrix2D &a ) const;
+    constexpr Matrix2D &operator*=( const Matrix2D &a );
 
-    Matrix2D operator*( double k ) const;
-    Matrix2D &operator*=( double k );
+    constexpr Matrix2D operator*( double k ) const;
+    constexpr Matrix2D &operator*=( double k );
 
-    Matrix2D operator/( double k ) const;
-    Matrix2D &operator/=( double k );
+    constexpr Matrix2D operator/( double k ) const;
+    constexpr Matrix2D &operator/=( double k );
 
-    Matrix2D operator+() const;
-    Matrix2D operator+( const Matrix2D &a ) const;
-    Matrix2D &operator+=( const Matrix2D &a );
+    constexpr Matrix2D operator+() const;
+    constexpr Matrix2D operator+( const Matrix2D &a ) const;
+    constexpr Matrix2D &operator+=( const Matrix2D &a );
 
-    Matrix2D operator-() const;
-    Matrix2D operator-( const Matrix2D &a ) const;
-    Matrix2D &operator-=( const Matrix2D &a );
+    constexpr Matrix2D operator-() const;
+    constexpr Matrix2D operator-( const Matrix2D &a ) const;
+    constexpr Matrix2D &operator-=( const Matrix2D &a );
 
     bool operator==( const Matrix2D &a ) const;
     bool operator!=( const Matrix2D &a ) const;
 
-    double det() const;
-    Matrix2D transpose() const;
-    Matrix2D cofactor() const;
-    Matrix2D adjugate() const;
+    constexpr double det() const;
+    constexpr Matrix2D transpose() const;
+    constexpr Matrix2D cofactor() const;
+    constexpr Matrix2D adjugate() const;
     Matrix2D inv() const;
 
-    static Matrix2D Zero();
-    static Matrix2D Identity();
-    static Matrix2D Scale( double s );
-    static Matrix2D Scale( double xs, double ys );
+    static constexpr Matrix2D Zero();
+    static constexpr Matrix2D Identity();
+    static constexpr Matrix2D Scale( double s );
+    static constexpr Matrix2D Scale( double xs, double ys );
     static Matrix2D Rotation( double angle );
 };
 
-Matrix2D operator*( double k, const Matrix2D &a );
+constexpr Matrix2D operator*( double k, const Matrix2D &a );
+
+constexpr Matrix2D::Matrix2D()
+    : a00( 0 ), a01( 0 ), a10( 0 ), a11( 0 )
+{}
+
+constexpr Matrix2D::Matrix2D( double a00_, double a01_, double a10_, double a11_ ): a00( a00_ ), a01( a01_ ), a10( a10_ ), a11( a11_ ) {}
+
+constexpr Matrix2D Matrix2D::operator*( const Matrix2D &a ) const
+{
+    return Matrix2D( a00 * a.a00 + a01 * a.a10, a00 * a.a01 + a01 * a.a11, a10 * a.a00 + a11 * a.a10, a10 * a.a01 + a11 * a.a11 );
+}
+
+constexpr Matrix2D &Matrix2D::operator*=( const Matrix2D &a )
+{
+    *this = *this * a;
+    return *this;
+}
+
+constexpr Matrix2D Matrix2D::operator*( double k ) const
+{
+    Matrix2D r;
+    r.a00 = a00 * k;
+    r.a01 = a01 * k;
+    r.a10 = a10 * k;
+    r.a11 = a11 * k;
+    return r;
+}
+
+constexpr Matrix2D &Matrix2D::operator*=( double k )
+{
+    a00 *= k;
+    a01 *= k;
+    a10 *= k;
+    a11 *= k;
+    return *this;
+}
+
+constexpr Matrix2D Matrix2D::operator/( double k ) const
+{
+    Matrix2D r;
+    r.a00 = a00 / k;
+    r.a01 = a01 / k;
+    r.a10 = a10 / k;
+    r.a11 = a11 / k;
+    return r;
+}
+
+constexpr Matrix2D &Matrix2D::operator/=( double k )
+{
+    a00 /= k;
+    a01 /= k;
+    a10 /= k;
+    a11 /= k;
+    return *this;
+}
+
+constexpr Matrix2D Matrix2D::operator+()const
+{
+    Matrix2D r;
+    r.a00 = +a00;
+    r.a01 = +a01;
+    r.a10 = +a10;
+    r.a11 = +a11;
+    return r;
+}
+
+constexpr Matrix2D Matrix2D::operator+( const Matrix2D &a ) const
+{
+    Matrix2D r;
+    r.a00 = a00 + a.a00;
+    r.a01 = a01 + a.a01;
+    r.a10 = a10 + a.a10;
+    r.a11 = a11 + a.a11;
+    return r;
+}
+
+constexpr Matrix2D &Matrix2D::operator+=( const Matrix2D &a )
+{
+    a00 += a.a00;
+    a01 += a.a01;
+    a10 += a.a10;
+    a11 += a.a11;
+    return *this;
+}
+
+constexpr Matrix2D Matrix2D::operator-()const
+{
+    Matrix2D r;
+    r.a00 = -a00;
+    r.a01 = -a01;
+    r.a10 = -a10;
+    r.a11 = -a11;
+    return r;
+}
+
+constexpr Matrix2D Matrix2D::operator-( const Matrix2D &a ) const
+{
+    Matrix2D r;
+    r.a00 = a00 - a.a00;
+    r.a01 = a01 - a.a01;
+    r.a10 = a10 - a.a10;
+    r.a11 = a11 - a.a11;
+    return r;
+}
+
+constexpr Matrix2D &Matrix2D::operator-=( const Matrix2D &a )
+{
+    a00 -= a.a00;
+    a01 -= a.a01;
+    a10 -= a.a10;
+    a11 -= a.a11;
+    return *this;
+}
+
+inline bool Matrix2D::operator==( const Matrix2D &a ) const
+{
+    return
+        ( Abs( a00 - a.a00 ) <= epsilon ) &&
+        ( Abs( a01 - a.a01 ) <= epsilon ) &&
+        ( Abs( a10 - a.a10 ) <= epsilon ) &&
+        ( Abs( a11 - a.a11 ) <= epsilon );
+}
+
+inline bool Matrix2D::operator!=( const Matrix2D &a ) const
+{
+    return
+        ( Abs( a00 - a.a00 ) > epsilon ) ||
+        ( Abs( a01 - a.a01 ) > epsilon ) ||
+        ( Abs( a10 - a.a10 ) > epsilon ) ||
+        ( Abs( a11 - a.a11 ) > epsilon );
+}
+
+constexpr double Matrix2D::det() const
+{
+    return a00 * a11 - a10 * a01;
+}
+
+constexpr Matrix2D Matrix2D::transpose() const
+{
+    return Matrix2D( a00, a10, a01, a11 );
+}
+
+constexpr Matrix2D Matrix2D::cofactor() const
+{
+    return Matrix2D( a11, -a10, -a01,  a00 );
+}
+
+constexpr Matrix2D Matrix2D::adjugate() const
+{
+    return cofactor().transpose();
+}
+
+inline Matrix2D Matrix2D::inv() const
+{
+    double d = det();
+    makeException( Abs( d ) > epsilon );
+    return adjugate() / d;
+}
+
+constexpr Matrix2D Matrix2D::Zero()
+{
+    return Matrix2D();
+}
+
+constexpr Matrix2D Matrix2D::Identity()
+{
+    return Matrix2D( 1, 0, 0, 1 );
+}
+
+constexpr Matrix2D Matrix2D::Scale( double s )
+{
+    return Matrix2D( s, 0, 0, s );
+}
+
+constexpr Matrix2D Matrix2D::Scale( double xs, double ys )
+{
+    return Matrix2D( xs, 0, 0, ys );
+}
+
+inline Matrix2D Matrix2D::Rotation( double angle )
+{
+    double c = Cos( angle );
+    double s = Sin( angle );
+    return Matrix2D( c, -s, s, c );
+}
+
+constexpr Matrix2D operator*( double k, const Matrix2D &a )
+{
+    return a * k;
+}
@@ -1,11 +1,111 @@
 #pragma once
 
+#include <type_traits>
+#include <utility>
+#include <cstdint>
+#include <cmath>
+
+#include "Decomposition.h"
+#include "MatrixExpression.h"
 #include "Exception.h"
+#include "Multiply.h"
+#include "Filter.h"
 #include "Matrix.h"
 
+// Operators return matrices, lazy() and lazyTransposed() start expressions from MatrixExpression.h
+// Chain of element-wise operations over expressions is computed in a single pass, when it is assigned to a matrix
 template<typename T>
 class MatrixArithmetic : public MatrixBase<T>
 {
+private:
+    // Type, that decompositions use: integers are decomposed as doubles
+    using Real = std::conditional_t<std::is_floating_point_v<T>, T, double>;
+
+    template<typename R, typename S>
+    static MatrixBase<R> convert( const MatrixBase<S> &matrix )
+    {
+        if constexpr( std::is_same_v<R, S> )
+        {
+            return matrix;
+        }
+        else
+        {
+            MatrixBase<R> result( matrix.w(), matrix.h() );
+            for( int i = 0; i < matrix.h(); ++i )
+            {
+                for( int j = 0; j < matrix.w(); ++j )
+                    *result( j, i ) = R( *matrix( j, i ) );
+            }
+            return result;
+        }
+    }
+
+    static MatrixArithmetic convert( const MatrixBase<Real> &matrix )
+    {
+        return convert<T>( matrix );
+    }
+
+    MatrixBase<Real> real() const
+    {
+        return convert<Real>( *this );
+    }
+
+    // Gaussian elimination of integers modulo 2^64, where every odd number has an inverse
+    // Pivot has the fewest trailing zero bits in its column, so lines below lose an integer multiple of pivot line
+    // Determinant is exact, when it fits into T, otherwise it wraps around, as arithmetic of T does
+    T modularDet() const
+    {
+        int size = w();
+        MatrixBase<uint64_t> a = convert<uint64_t>( *this );
+
+        uint64_t result = 1;
+        for( int k = 0; k < size; ++k )
+        {
+            int pivot = k, zeros = 64;
+            for( int i = k; i < size && zeros > 0; ++i )
+            {
+                uint64_t value = *a( k, i );
+                int count = 0;
+                while( count < zeros && ( ( value >> count ) & 1 ) == 0 )
+                    ++count;
+
+                if( count < zeros )
+                {
+                    pivot = i;
+                    zeros = count;
+                }
+            }
+
+            // Column is zero modulo 2^64
+            if( zeros == 64 )
+                return T();
+
+            if( pivot != k )
+            {
+                for( int j = k; j < size; ++j )
+                    std::swap( *a( j, k ), *a( j, pivot ) );
+                result = 0 - result;
+            }
+
+            // Newton iterations double correct low bits of inverse, odd number is its own inverse in 3 bits
+            uint64_t odd = *a( k, k ) >> zeros, inverse = odd;
+            for( int n = 0; n < 5; ++n )
+                inverse *= 2 - odd * inverse;
+
+            for( int i = k + 1; i < size; ++i )
+            {
+                uint64_t factor = ( *a( k, i ) >> zeros ) * inverse;
+                if( factor == 0 )
+                    continue;
+
+                for( int j = k; j < size; ++j )
+                    *a( j, i ) -= factor * *a( j, k );
+            }
+            result *= *a( k, k );
+        }
+
+        return T( result );
+    }
 public:
     using MatrixBase<T>::w;
     using MatrixBase<T>::h;
@@ -38,40 +138,57 @@ public:
         return *( ( MatrixBase<T> * )this ) = other;
     }
 
-    MatrixArithmetic &operator+=( const MatrixArithmetic &other )
+    template<typename E>
+    MatrixArithmetic( const MatrixExpression<T, E> &expression )
+        : MatrixBase<T>()
     {
-        // Matrix dimensions must match for addition
-        makeException( w() == other.w() && h() == other.h() );
+        *this = expression;
+    }
 
-        for( int i = 0; i < h(); ++i )
+    template<typename E>
+    MatrixArithmetic &operator=( const MatrixExpression<T, E> &expression )
+    {
+        evaluate( *this, expression, []( T &target, const T &value )
         {
-            for( int j = 0; j < w(); ++j )
-            {
-                *( *this )( j, i ) += *other( j, i );
-            }
-        }
+            target = value;
+        }, true );
         return *this;
     }
 
-    MatrixArithmetic &operator*=( const MatrixArithmetic &other )
+    template<typename E>
+    MatrixArithmetic &operator+=( const MatrixExpression<T, E> &expression )
     {
-        // Matrix dimensions must match for multiplication
-        makeException( w() == other.h() );
+        evaluate( *this, expression, []( T &target, const T &value )
+        {
+            target += value;
+        }, false );
+        return *this;
+    }
 
-        MatrixArithmetic result( other.w(), h() );
-        for( int i = 0; i < result.h(); ++i )
+    template<typename E>
+    MatrixArithmetic &operator-=( const MatrixExpression<T, E> &expression )
+    {
+        evaluate( *this, expression, []( T &target, const T &value )
         {
-            for( int j = 0; j < result.w(); ++j )
-            {
-                T value = T();
-                for( int k = 0; k < w(); ++k )
-                {
-                    value += *( *this )( k, i ) * *other( j, k );
-                }
-                *result( j, i ) = value;
-            }
-        }
+            target -= value;
+        }, false );
+        return *this;
+    }
+
+    MatrixArithmetic &operator+=( const MatrixArithmetic &other )
+    {
+        return *this += other.lazy();
+    }
 
+    MatrixArithmetic &operator-=( const MatrixArithmetic &other )
+    {
+        return *this -= other.lazy();
+    }
+
+    MatrixArithmetic &operator*=( const MatrixArithmetic &other )
+    {
+        MatrixArithmetic result;
+        multiply<T>( *this, other, result );
         *this = std::move( result );
         return *this;
     }
@@ -88,50 +205,64 @@ public:
         return *this;
     }
 
+    // Matrix as a term of expression, expression keeps reference to matrix, so it must be assigned, before matrix is destroyed
+    MatrixReference<T> lazy() const
+    {
+        return { *this };
+    }
+
+    MatrixTransposed<T> lazyTransposed() const
+    {
+        return { *this };
+    }
+
     MatrixArithmetic operator+( const MatrixArithmetic &other ) const
     {
-        MatrixArithmetic result = *this;
-        result += other;
-        return result;
+        return lazy() + other.lazy();
+    }
+
+    MatrixArithmetic operator-( const MatrixArithmetic &other ) const
+    {
+        return lazy() - other.lazy();
+    }
+
+    MatrixArithmetic operator-() const
+    {
+        return -lazy();
     }
 
     MatrixArithmetic operator*( const MatrixArithmetic &other ) const
     {
-        MatrixArithmetic result = *this;
-        result *= other;
+        MatrixArithmetic result;
+        multiply<T>( *this, other, result );
         return result;
     }
 
     MatrixArithmetic operator*( const T &scalar ) const
     {
-        MatrixArithmetic result = *this;
-        result *= scalar;
-        return result;
+        return lazy() * scalar;
     }
 
-    MatrixArithmetic convolution( const MatrixArithmetic &kernel ) const
+    MatrixArithmetic hadamardProduct( const MatrixArithmetic &other ) const
     {
-        // Kernel size must not exceed matrix size
-        makeException( kernel.w() <= w() && kernel.h() <= h() );
+        return hadamard( lazy(), other.lazy() );
+    }
 
-        MatrixArithmetic result( w() - kernel.w() + 1, h() - kernel.h() + 1 );
+    MatrixArithmetic transposed() const
+    {
+        return lazyTransposed();
+    }
 
-        for( int i = 0; i < result.h(); ++i )
-        {
-            for( int j = 0; j < result.w(); ++j )
-            {
-                T value = T();
-                for( int ki = 0; ki < kernel.h(); ++ki )
-                {
-                    for( int kj = 0; kj < kernel.w(); ++kj )
-                    {
-                        value += *( *this )( j + kj, i + ki ) * *kernel( kj, ki );
-                    }
-                }
-                *result( j, i ) = value;
-            }
-        }
+    // Computes convolution without border into 'result', which is reused, if it has the needed size
+    void convolution( const MatrixArithmetic &kernel, MatrixArithmetic &result ) const
+    {
+        validConvolution<T>( *this, kernel, result );
+    }
 
+    MatrixArithmetic convolution( const MatrixArithmetic &kernel ) const
+    {
+        MatrixArithmetic result;
+        convolution( kernel, result );
         return result;
     }
 
@@ -169,31 +300,26 @@ public:
         if( size == 2 )
             return *( *this )( 0, 0 ) * *( *this )( 1, 1 ) - *( *this )( 0, 1 ) * *( *this )( 1, 0 );
 
-        T result = T();
-        for( int j = 0; j < size; ++j )
+        // Floating point types use LU decomposition, integers are eliminated modulo 2^64 without rounding
+        if constexpr( std::is_floating_point_v<T> )
         {
-            T cofactor = *( *this )( j, 0 ) * ( ( j % 2 == 0 ) ? 1 : -1 );
-            result += cofactor * minor( j, 0 ).det();
+            return LUDecomposition<T>( *this ).det();
         }
-
-        return result;
-    }
-
-    MatrixArithmetic hadamardProduct( const MatrixArithmetic &other ) const
-    {
-        // Matrix dimensions must match for Hadamard product
-        makeException( w() == other.w() && h() == other.h() );
-
-        MatrixArithmetic result( w(), h() );
-        for( int i = 0; i < h(); ++i )
+        else if constexpr( std::is_integral_v<T> )
         {
-            for( int j = 0; j < w(); ++j )
+            return modularDet();
+        }
+        else
+        {
+            T result = T();
+            for( int j = 0; j < size; ++j )
             {
-                *result( j, i ) = *( *this )( j, i ) * *other( j, i );
+                T cofactor = *( *this )( j, 0 ) * ( ( j % 2 == 0 ) ? 1 : -1 );
+                result += cofactor * minor( j, 0 ).det();
             }
-        }
 
-        return result;
+            return result;
+        }
     }
 
     MatrixArithmetic<T> adjugate() const
@@ -204,6 +330,18 @@ public:
         int size = w();
         MatrixArithmetic<T> result( size, size );
 
+        // Adjugate of invertible matrix is its inverse multiplied by determinant
+        if constexpr( std::is_floating_point_v<T> )
+        {
+            LUDecomposition<T> lu( *this );
+            if( size > 2 && !lu.singular() )
+            {
+                lu.inverse( result );
+                result *= lu.det();
+                return result;
+            }
+        }
+
         for( int i = 0; i < size; ++i )
         {
             for( int j = 0; j < size; ++j )
@@ -220,23 +358,31 @@ public:
         // Inverse is only defined for square matrices
         makeException( w() == h() );
 
-        T determinantValue = det();
+        LUDecomposition<Real> lu( real() );
 
         // Matrix is singular and cannot be inverted
-        makeException( determinantValue < T() || determinantValue > T() );
+        makeException( !lu.singular() );
 
-        MatrixArithmetic<T> adj = adjugate();
-        MatrixArithmetic<T> result( w(), h() );
-        T invDet = T( 1 ) / determinantValue;
+        MatrixBase<Real> result;
+        lu.inverse( result );
+        return convert( result );
+    }
 
-        for( int i = 0; i < h(); ++i )
-        {
-            for( int j = 0; j < w(); ++j )
-            {
-                *result( j, i ) = *adj( j, i ) * invDet;
-            }
-        }
+    // Solves this * x = b for every column of 'b', which has as many lines, as this matrix
+    // Square matrices use LU decomposition, others give solution with the least squared error through QR decomposition
+    MatrixArithmetic solve( const MatrixArithmetic &b ) const
+    {
+        MatrixBase<Real> result;
+        if( w() == h() )
+            LUDecomposition<Real>( real() ).solve( convert<Real>( b ), result );
+        else
+            QRDecomposition<Real>( real() ).solve( convert<Real>( b ), result );
+        return convert( result );
+    }
 
-        return result;
+    // Number of linearly independent columns
+    int rank() const
+    {
+        return QRDecomposition<Real>( real() ).rank();
     }
 };
@@ -0,0 +1 @@
+#include "MatrixExpression.h"
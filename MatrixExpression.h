@@ -0,0 +1,337 @@
+#pragma once
+
+#include <type_traits>
+#include <utility>
+
+#include "Exception.h"
+#include "Parallel.h"
+#include "Matrix.h"
+#include "Basic.h"
+
+// Lines with less values than this are evaluated by one thread
+#define EXPRESSION_GRANULE 65536
+
+template<typename T>
+class MatrixArithmetic;
+
+// Element-wise expression over matrices, that isn't computed, until it is assigned to a matrix
+// Whole chain is then computed in a single pass, line by line, without temporary matrices
+// Every expression 'E' has w(), h() and line( i ), that returns object with operator[], which computes value of column j
+// Expressions start from MatrixArithmetic::lazy() or lazyTransposed() and keep references to matrices,
+// so they must be assigned, before those matrices are destroyed
+template<typename T, typename E>
+struct MatrixExpression
+{
+    using Value = T;
+
+    const E &expression() const
+    {
+        return static_cast<const E &>( *this );
+    }
+
+    // Computes expression into matrix
+    MatrixArithmetic<T> eval() const
+    {
+        return MatrixArithmetic<T>( expression() );
+    }
+};
+
+// Matrix as a term of expression
+template<typename T>
+struct MatrixReference : public MatrixExpression<T, MatrixReference<T>>
+{
+    const MatrixBase<T> &matrix;
+
+    MatrixReference( const MatrixBase<T> &m ) : matrix( m )
+    {}
+
+    int w() const
+    {
+        return matrix.w();
+    }
+
+    int h() const
+    {
+        return matrix.h();
+    }
+
+    const T *line( int i ) const
+    {
+        return matrix( 0, i );
+    }
+
+    // Value is read at the same position, where it is written, so matrix may be target of assignment
+    bool overlaps( const MatrixBase<T> & ) const
+    {
+        return false;
+    }
+};
+
+// Transposed matrix as a term of expression, its lines are columns of matrix
+template<typename T>
+struct MatrixTransposed : public MatrixExpression<T, MatrixTransposed<T>>
+{
+    struct Line
+    {
+        const T *values;
+        int stride;
+
+        T operator[]( int j ) const
+        {
+            return values[j * stride];
+        }
+    };
+
+    const MatrixBase<T> &matrix;
+
+    MatrixTransposed( const MatrixBase<T> &m ) : matrix( m )
+    {}
+
+    int w() const
+    {
+        return matrix.h();
+    }
+
+    int h() const
+    {
+        return matrix.w();
+    }
+
+    Line line( int i ) const
+    {
+        return { matrix( i, 0 ), matrix.s() };
+    }
+
+    bool overlaps( const MatrixBase<T> &target ) const
+    {
+        return &matrix == &target;
+    }
+};
+
+struct MatrixSum
+{
+    template<typename T>
+    static T apply( const T &a, const T &b )
+    {
+        return a + b;
+    }
+};
+
+struct MatrixDifference
+{
+    template<typename T>
+    static T apply( const T &a, const T &b )
+    {
+        return a - b;
+    }
+};
+
+// Element-wise product
+struct MatrixHadamard
+{
+    template<typename T>
+    static T apply( const T &a, const T &b )
+    {
+        return a * b;
+    }
+};
+
+// Operands are kept by value, they are small and refer to matrices
+template<typename T, typename L, typename R, typename O>
+struct MatrixBinary : public MatrixExpression<T, MatrixBinary<T, L, R, O>>
+{
+    L left;
+    R right;
+
+    struct Line
+    {
+        decltype( std::declval<const L &>().line( 0 ) ) a;
+        decltype( std::declval<const R &>().line( 0 ) ) b;
+
+        T operator[]( int j ) const
+        {
+            return O::apply( T( a[j] ), T( b[j] ) );
+        }
+    };
+
+    MatrixBinary( const L &l, const R &r ) : left( l ), right( r )
+    {
+        // Matrix dimensions must match for element-wise operation
+        makeException( left.w() == right.w() && left.h() == right.h() );
+    }
+
+    int w() const
+    {
+        return left.w();
+    }
+
+    int h() const
+    {
+        return left.h();
+    }
+
+    Line line( int i ) const
+    {
+        return { left.line( i ), right.line( i ) };
+    }
+
+    bool overlaps( const MatrixBase<T> &target ) const
+    {
+        return left.overlaps( target ) || right.overlaps( target );
+    }
+};
+
+// Expression multiplied by scalar
+template<typename T, typename E>
+struct MatrixScaled : public MatrixExpression<T, MatrixScaled<T, E>>
+{
+    E operand;
+    T factor;
+
+    struct Line
+    {
+        decltype( std::declval<const E &>().line( 0 ) ) a;
+        T k;
+
+        T operator[]( int j ) const
+        {
+            return a[j] * k;
+        }
+    };
+
+    MatrixScaled( const E &e, const T &k ) : operand( e ), factor( k )
+    {}
+
+    int w() const
+    {
+        return operand.w();
+    }
+
+    int h() const
+    {
+        return operand.h();
+    }
+
+    Line line( int i ) const
+    {
+        return { operand.line( i ), factor };
+    }
+
+    bool overlaps( const MatrixBase<T> &target ) const
+    {
+        return operand.overlaps( target );
+    }
+};
+
+template<typename T, typename E>
+struct MatrixNegated : public MatrixExpression<T, MatrixNegated<T, E>>
+{
+    E operand;
+
+    struct Line
+    {
+        decltype( std::declval<const E &>().line( 0 ) ) a;
+
+        T operator[]( int j ) const
+        {
+            return -a[j];
+        }
+    };
+
+    MatrixNegated( const E &e ) : operand( e )
+    {}
+
+    int w() const
+    {
+        return operand.w();
+    }
+
+    int h() const
+    {
+        return operand.h();
+    }
+
+    Line line( int i ) const
+    {
+        return { operand.line( i ) };
+    }
+
+    bool overlaps( const MatrixBase<T> &target ) const
+    {
+        return operand.overlaps( target );
+    }
+};
+
+template<typename T, typename L, typename R>
+MatrixBinary<T, L, R, MatrixSum> operator+( const MatrixExpression<T, L> &left, const MatrixExpression<T, R> &right )
+{
+    return { left.expression(), right.expression() };
+}
+
+template<typename T, typename L, typename R>
+MatrixBinary<T, L, R, MatrixDifference> operator-( const MatrixExpression<T, L> &left, const MatrixExpression<T, R> &right )
+{
+    return { left.expression(), right.expression() };
+}
+
+template<typename T, typename E>
+MatrixNegated<T, E> operator-( const MatrixExpression<T, E> &operand )
+{
+    return { operand.expression() };
+}
+
+template<typename T, typename E>
+MatrixScaled<T, E> operator*( const MatrixExpression<T, E> &operand, const typename MatrixExpression<T, E>::Value &k )
+{
+    return { operand.expression(), k };
+}
+
+template<typename T, typename E>
+MatrixScaled<T, E> operator*( const typename MatrixExpression<T, E>::Value &k, const MatrixExpression<T, E> &operand )
+{
+    return { operand.expression(), k };
+}
+
+template<typename T, typename L, typename R>
+MatrixBinary<T, L, R, MatrixHadamard> hadamard( const MatrixExpression<T, L> &left, const MatrixExpression<T, R> &right )
+{
+    return { left.expression(), right.expression() };
+}
+
+// Computes expression and combines its values with values of 'target' as 'function( target, value )'
+// Target of the same size is reused, target, that is read transposed, is replaced after computation
+template<typename T, typename E, typename F>
+void evaluate( MatrixBase<T> &target, const MatrixExpression<T, E> &expression, F function, bool resize )
+{
+    const E &source = expression.expression();
+    int width = source.w(), height = source.h();
+
+    if( source.overlaps( target ) )
+    {
+        MatrixBase<T> temporary( target );
+        evaluate( temporary, expression, function, resize );
+        target = std::move( temporary );
+        return;
+    }
+
+    if( target.w() != width || target.h() != height )
+    {
+        // Matrix dimensions must match for element-wise operation
+        makeException( resize );
+        target.reset( width, height );
+    }
+
+    if( target.empty() )
+        return;
+
+    parallelFor( height, [&]( size_t begin, size_t end )
+    {
+        for( int i = begin; i < int( end ); ++i )
+        {
+            auto values = source.line( i );
+            T *line = target( 0, i );
+            for( int j = 0; j < width; ++j )
+                function( line[j], T( values[j] ) );
+        }
+    }, Max( EXPRESSION_GRANULE / Max( width, 1 ), 1 ) );
+}
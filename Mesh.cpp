@@ -5,50 +5,13 @@
 #include <set>
 
 #include "Exception.h"
+#include "MeshTree.h"
 #include "Scanner.h"
 #include "Polygon.h"
 #include "Basic.h"
 
 // ---------------- Helpers ----------------
 
-// Line p0, p1
-// Triangle v0, v1, v2
-// The intersection point p
-// Parameter t along line segment: p = p0 + t( p1 - p0 )
-// Barycentric coordinates u, v in triangle: p = v0 + u( v1 - v0 ) + v( v2 - v0 )
-// Returns true, if p lies within the triangle and line hits triangle from the front
-static bool intersectSegmentTriangle(
-    const Vector3D &p0, const Vector3D &p1,
-    const Vector3D &v0, const Vector3D &v1, const Vector3D &v2,
-    double &u, double &v, double &t
-)
-{
-    auto dir = p1 - p0;
-    auto edge1 = v1 - v0;
-    auto edge2 = v2 - v0;
-
-    if( dir * edge1.M( edge2 ) >= 0 )
-        return false; // Hits a face from the back
-
-    // Möller–Trumbore intersection
-
-    auto pvec = dir.M( edge2 );
-    double det = edge1 * pvec;
-    if( Abs( det ) < Vector3D::epsilon )
-        return false; // Parallel or degenerate
-
-    double invDet = 1.0 / det;
-
-    auto tvec = p0 - v0;
-    auto qvec = tvec.M( edge1 );
-
-    u = ( tvec * pvec ) * invDet;
-    v = ( dir * qvec ) * invDet;
-    t = ( edge2 * qvec ) * invDet;
-
-    return u >= 0.0 && v >= 0.0 && u + v <= 1.0;
-}
-
 class DiscreteFunction
 {
 public:
@@ -605,7 +568,10 @@ Mesh::Mesh( const Mesh &other ) :
     edges( other.edges ),
     faces( other.faces ),
     groups( other.groups )
-{}
+{
+    std::lock_guard<std::mutex> lock( other.treeMutex );
+    tree = other.tree;
+}
 
 Mesh::Mesh( Mesh &&other ) :
     materialsFile( std::move( other.materialsFile ) ),
@@ -615,7 +581,10 @@ Mesh::Mesh( Mesh &&other ) :
     edges( std::move( other.edges ) ),
     faces( std::move( other.faces ) ),
     groups( std::move( other.groups ) )
-{}
+{
+    std::lock_guard<std::mutex> lock( other.treeMutex );
+    tree = std::move( other.tree );
+}
 
 Mesh &Mesh::operator=( const Mesh &other )
 {
@@ -626,6 +595,10 @@ Mesh &Mesh::operator=( const Mesh &other )
     edges = other.edges;
     faces = other.faces;
     groups = other.groups;
+
+    auto otherTree = other.hierarchyIfBuilt();
+    std::lock_guard<std::mutex> lock( treeMutex );
+    tree = std::move( otherTree );
     return*this;
 }
 
@@ -638,31 +611,77 @@ Mesh &Mesh::operator=( Mesh &&other )
     edges = std::move( other.edges );
     faces = std::move( other.faces );
     groups = std::move( other.groups );
+
+    auto otherTree = other.hierarchyIfBuilt();
+    other.changed();
+    std::lock_guard<std::mutex> lock( treeMutex );
+    tree = std::move( otherTree );
     return*this;
 }
 
 std::optional<size_t> Mesh::intersectSegment( const Vector3D &p0, const Vector3D &p1, double &u, double &v, double &t ) const
 {
-    double u0, v0, t0, tMin = std::numeric_limits<double>::max();
-    std::optional<size_t> faceId;
+    return hierarchy()->intersectSegment( p0, p1, u, v, t );
+}
 
-    size_t i = 0;
-    for( auto tri : *this )
-    {
-        if( intersectSegmentTriangle( p0, p1, tri.p.a, tri.p.b, tri.p.c, u0, v0, t0 ) )
-        {
-            if( t0 < tMin )
-            {
-                faceId = i;
-                t = tMin = t0;
-                u = u0;
-                v = v0;
-            }
-        }
-        ++i;
-    }
+void Mesh::intersectSegments( const Vector3D *p0, const Vector3D *p1, size_t count, Hit *hits, bool any ) const
+{
+    hierarchy()->intersectSegments( p0, p1, count, hits, any );
+}
+
+Mesh::Nearest Mesh::closestPoint( const Vector3D &p ) const
+{
+    return hierarchy()->closestPoint( p );
+}
+
+double Mesh::signedDistance( const Vector3D &p ) const
+{
+    return hierarchy()->signedDistance( p );
+}
+
+std::vector<size_t> Mesh::nearestPoints( const Vector3D &p, size_t k ) const
+{
+    return hierarchy()->nearestPoints( p, k );
+}
+
+std::vector<size_t> Mesh::facesWithin( const Vector3D &p, double radius ) const
+{
+    return hierarchy()->facesWithin( p, radius );
+}
 
-    return faceId;
+std::vector<size_t> Mesh::facesInBox( const Vector3D &low, const Vector3D &high ) const
+{
+    return hierarchy()->facesInBox( low, high );
+}
+
+void Mesh::closestPoints( const Vector3D *p, size_t count, Nearest *results ) const
+{
+    hierarchy()->closestPoints( p, count, results );
+}
+
+void Mesh::signedDistances( const Vector3D *p, size_t count, double *results ) const
+{
+    hierarchy()->signedDistances( p, count, results );
+}
+
+std::shared_ptr<const MeshTree> Mesh::hierarchy() const
+{
+    std::lock_guard<std::mutex> lock( treeMutex );
+    if( !tree )
+        tree = std::make_shared<const MeshTree>( *this );
+    return tree;
+}
+
+std::shared_ptr<const MeshTree> Mesh::hierarchyIfBuilt() const
+{
+    std::lock_guard<std::mutex> lock( treeMutex );
+    return tree;
+}
+
+void Mesh::changed()
+{
+    std::lock_guard<std::mutex> lock( treeMutex );
+    tree.reset();
 }
 
 void Mesh::cube()
@@ -1094,6 +1113,8 @@ void Mesh::normalize()
 
 void Mesh::optimize()
 {
+    changed();
+
     Bitset usedEdges, usedNormals, usedTexturing, usedPoints;
 
     usedEdges.resize( edges.size() );
@@ -1163,6 +1184,8 @@ void Mesh::optimize()
 
 void Mesh::invert()
 {
+    changed();
+
     for( auto& edge : edges )
         std::swap( edge.s, edge.f );
 
@@ -1176,6 +1199,8 @@ void Mesh::invert()
 
 bool Mesh::sortFacesByGroup( int id )
 {
+    changed();
+
     auto s = groups.group( id );
     if( !s )
         return false;
@@ -1210,10 +1235,47 @@ bool Mesh::sortFacesByGroup( int id )
 
 void Mesh::transform( const Affine3D &f )
 {
-    for( auto &p : points )
-        p = f( p );
+    f.apply( points.data(), points.data(), points.size() );
+
+    auto old = hierarchyIfBuilt();
+    if( old )
+    {
+        auto refitted = std::make_shared<MeshTree>( *old );
+        refitted->refit( *this );
+        std::lock_guard<std::mutex> lock( treeMutex );
+        tree = std::move( refitted );
+    }
+
+    Affine3D( f.t ).apply( normals.data(), normals.data(), normals.size() );
     for( auto &n : normals )
-        n = ( f.t * n ).Normal();
+        n = n.Normal();
+}
+
+SparseMatrix<double> Mesh::laplacian() const
+{
+    int n = int( points.size() );
+    SparseTriplets<double> triplets( n, n );
+    for( auto &f : faces )
+    {
+        size_t corners[3] = { edges[f.p.a].s, edges[f.p.b].s, edges[f.p.c].s };
+        for( int k = 0; k < 3; ++k )
+        {
+            int a = int( corners[k] ), b = int( corners[( k + 1 ) % 3] ), c = int( corners[( k + 2 ) % 3] );
+            auto u = points[b] - points[a], v = points[c] - points[a];
+
+            // Degenerate faces don't have angles
+            double area = u.M( v ).Abs();
+            if( area <= 0 )
+                continue;
+
+            double weight = 0.5 * ( u * v ) / area;
+            triplets.add( c, b, -weight );
+            triplets.add( b, c, -weight );
+            triplets.add( b, b, weight );
+            triplets.add( c, c, weight );
+        }
+    }
+    return SparseMatrix<double>( std::move( triplets ) );
 }
 
 static std::map<Mesh::Edge, size_t> buildEdgeToFaceMap( const std::vector<Mesh::Edge>& edges, const std::vector<Mesh::Face>& faces )
@@ -1282,6 +1344,8 @@ static std::map<size_t, std::vector<size_t>> buildTextureToFacesMap( const std::
 
 void Mesh::setPoints( const std::function<void( Vector3D &, const std::vector<size_t>& faces )>& f )
 {
+    changed();
+
     for( const auto& [pointId, faceList] : buildPointToFacesMap( edges, faces ) )
         f( points[pointId], faceList );
 }
@@ -1300,6 +1364,8 @@ void Mesh::setTexturing( const std::function<void( Vector3D &, const std::vector
 
 void Mesh::setPoints( const std::function<void( Vector3D & )>& f )
 {
+    changed();
+
     for( auto& point : points )
         f( point );
 }
@@ -1318,6 +1384,8 @@ void Mesh::setTexturing( const std::function<void( Vector3D & )>& f )
 
 void Mesh::clear()
 {
+    changed();
+
     materialsFile.reset();
     points.clear();
     normals.clear();
@@ -1762,6 +1830,9 @@ Mesh::Data<Vector3D&> Mesh::operator[]( size_t id )
 {
     makeException( id < faces.size() );
 
+    // Points may be changed through references
+    changed();
+
     auto &f = faces[id];
     V3<Edge> e{ edges[f.p.a], edges[f.p.b], edges[f.p.c] };
     Va3<Vector3D&> p{ points[e.a.s], points[e.b.s], points[e.c.s] };
@@ -2,7 +2,9 @@
 
 #include <filesystem>
 #include <functional>
+#include <memory>
 #include <vector>
+#include <mutex>
 #include <map>
 
 #include "Information.h"
@@ -10,6 +12,9 @@
 #include "Vector3D.h"
 #include "Affine3D.h"
 #include "Bitset.h"
+#include "Sparse.h"
+
+class MeshTree;
 
 class Mesh
 {
@@ -63,8 +68,55 @@ public:
     Mesh &operator=( const Mesh &other );
     Mesh &operator=( Mesh &&other );
 
+    struct Hit
+    {
+        // Face, that segment hits, empty, if it doesn't hit any
+        std::optional<size_t> face;
+        double u, v, t;
+    };
+
+    // Uses hierarchy of faces
     std::optional<size_t> intersectSegment( const Vector3D &p0, const Vector3D &p1, double &u, double &v, double &t ) const;
 
+    // Finds hits of 'count' segments from p0[k] to p1[k], same as intersectSegment, on several threads
+    // With 'any' segment stops on the first face, that it crosses between its ends ( 0 <= t <= 1 ), which suits visibility
+    void intersectSegments( const Vector3D *p0, const Vector3D *p1, size_t count, Hit *hits, bool any = false ) const;
+
+    struct Nearest
+    {
+        // Nearest face, empty, if mesh has no faces
+        std::optional<size_t> face;
+
+        // Nearest point is a + u( b - a ) + v( c - a ) for corners a, b, c of face, same as in intersectSegment
+        double u, v;
+        Vector3D point;
+        double distance;
+    };
+
+    // Nearest point of faces to 'p', among equally near faces the one with the lowest index is chosen
+    Nearest closestPoint( const Vector3D &p ) const;
+
+    // Distance to faces, negative inside, infinity for mesh without faces
+    // Sign is given by angle-weighted pseudo-normal of the nearest face, edge or point, so mesh must be closed and consistently directed
+    double signedDistance( const Vector3D &p ) const;
+
+    // Up to 'k' nearest points, that faces use, ordered by distance to 'p'
+    std::vector<size_t> nearestPoints( const Vector3D &p, size_t k ) const;
+
+    // Sorted indices of faces, that have points not farther than 'radius' from 'p'
+    std::vector<size_t> facesWithin( const Vector3D &p, double radius ) const;
+
+    // Sorted indices of faces, that intersect box [low, high]
+    std::vector<size_t> facesInBox( const Vector3D &low, const Vector3D &high ) const;
+
+    // Same as closestPoint and signedDistance for 'count' points on several threads
+    void closestPoints( const Vector3D *p, size_t count, Nearest *results ) const;
+    void signedDistances( const Vector3D *p, size_t count, double *results ) const;
+
+    // Bounding volume hierarchy over faces, it is built on first use and kept, until points or faces change
+    // Transformations refit it instead of building it again
+    std::shared_ptr<const MeshTree> hierarchy() const;
+
     void cube(); // Unit cube
     void plane( size_t rows, size_t columns ); // Subdivided unit plane
     void prism( const std::vector<Vector2D>& base ); // Prism of height one
@@ -89,6 +141,11 @@ public:
     void setNormals( const std::function<void( Vector3D & normal )>& f );
     void setTexturing( const std::function<void( Vector3D & texture )>& f );
 
+    // Cotangent Laplacian over points: value for edge between points i and j is -( cot a + cot b ) / 2,
+    // where a and b are angles opposite to the edge, diagonal value is minus sum of other values of line
+    // Matrix is symmetric positive semi-definite, lines of points, that faces don't use, are empty
+    SparseMatrix<double> laplacian() const;
+
     void clear();
 
     std::optional<std::filesystem::path>& getMaterialsFile();
@@ -190,4 +247,12 @@ private:
     std::vector<Edge> edges;
     std::vector<Face> faces;
     Groups groups;
+
+    mutable std::shared_ptr<const MeshTree> tree;
+    mutable std::mutex treeMutex;
+
+    std::shared_ptr<const MeshTree> hierarchyIfBuilt() const;
+
+    // Drops hierarchy, must be called by every method, that changes points or faces
+    void changed();
 };
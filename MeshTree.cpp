@@ -0,0 +1,896 @@
+#include "MeshTree.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+
+#include "Exception.h"
+#include "Parallel.h"
+#include "Basic.h"
+
+static double axisOf( const Vector3D &v, int axis )
+{
+    return axis == 0 ? v.x : ( axis == 1 ? v.y : v.z );
+}
+
+// Widens box by rounding errors of its coordinates, so hits, that are computed with rounding, stay inside of it
+static void pad( MeshTree::Box &box )
+{
+    Vector3D size = box.high - box.low;
+    double scale = Max( Max( Abs( box.low.x ), Abs( box.high.x ) ), Max( Max( Abs( box.low.y ), Abs( box.high.y ) ), Max( Abs( box.low.z ), Abs( box.high.z ) ) ) );
+    double margin = 1e-9 * ( Max( Max( size.x, size.y ), size.z ) + scale );
+    box.low -= Vector3D( margin, margin, margin );
+    box.high += Vector3D( margin, margin, margin );
+}
+
+// Squared distance from 'p' to box, zero inside of it
+static double boxDistance( const MeshTree::Box &box, const Vector3D &p )
+{
+    double x = Max( Max( box.low.x - p.x, p.x - box.high.x ), 0.0 );
+    double y = Max( Max( box.low.y - p.y, p.y - box.high.y ), 0.0 );
+    double z = Max( Max( box.low.z - p.z, p.z - box.high.z ), 0.0 );
+    return x * x + y * y + z * z;
+}
+
+// Separating axis test of box with 'center' and half of sizes 'half' against triangle
+static bool overlapBoxTriangle( const Vector3D &center, const Vector3D &half, const Vector3D *corner )
+{
+    Vector3D v[3] = { corner[0] - center, corner[1] - center, corner[2] - center };
+    Vector3D sides[3] = { v[1] - v[0], v[2] - v[1], v[0] - v[2] };
+    Vector3D axes[3] = { Vector3D( 1, 0, 0 ), Vector3D( 0, 1, 0 ), Vector3D( 0, 0, 1 ) };
+
+    auto separates = [&]( const Vector3D &axis )
+    {
+        double p0 = axis * v[0], p1 = axis * v[1], p2 = axis * v[2];
+        double r = half.x * Abs( axis.x ) + half.y * Abs( axis.y ) + half.z * Abs( axis.z );
+        return Min( Min( p0, p1 ), p2 ) > r || Max( Max( p0, p1 ), p2 ) < -r;
+    };
+
+    // Axes of box, normal of triangle and products of axes of box with sides of triangle
+    for( auto &axis : axes )
+    {
+        if( separates( axis ) )
+            return false;
+    }
+
+    if( separates( sides[0].M( sides[1] ) ) )
+        return false;
+
+    for( auto &side : sides )
+    {
+        for( auto &axis : axes )
+        {
+            if( separates( axis.M( side ) ) )
+                return false;
+        }
+    }
+    return true;
+}
+
+MeshTree::Box::Box()
+    : low( std::numeric_limits<double>::infinity(), std::numeric_limits<double>::infinity(), std::numeric_limits<double>::infinity() ),
+      high( -std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::infinity() )
+{}
+
+void MeshTree::Box::add( const Vector3D &p )
+{
+    low = Vector3D( Min( low.x, p.x ), Min( low.y, p.y ), Min( low.z, p.z ) );
+    high = Vector3D( Max( high.x, p.x ), Max( high.y, p.y ), Max( high.z, p.z ) );
+}
+
+void MeshTree::Box::add( const Box &b )
+{
+    low = Vector3D( Min( low.x, b.low.x ), Min( low.y, b.low.y ), Min( low.z, b.low.z ) );
+    high = Vector3D( Max( high.x, b.high.x ), Max( high.y, b.high.y ), Max( high.z, b.high.z ) );
+}
+
+bool MeshTree::Box::empty() const
+{
+    return !( low.x <= high.x );
+}
+
+double MeshTree::Box::area() const
+{
+    if( empty() )
+        return 0;
+
+    Vector3D size = high - low;
+    return 2 * ( size.x * size.y + size.y * size.z + size.z * size.x );
+}
+
+MeshTree::MeshTree( const Mesh &mesh )
+{
+    auto &points = mesh.getPoints();
+    auto &edges = mesh.getEdges();
+    auto &meshFaces = mesh.getFaces();
+
+    std::vector<Box> boxes( meshFaces.size() );
+    faces.resize( meshFaces.size() );
+    for( size_t k = 0; k < meshFaces.size(); ++k )
+    {
+        auto &f = meshFaces[k];
+        boxes[k].add( points[edges[f.p.a].s] );
+        boxes[k].add( points[edges[f.p.b].s] );
+        boxes[k].add( points[edges[f.p.c].s] );
+        pad( boxes[k] );
+        faces[k] = k;
+    }
+
+    build( boxes );
+    fill( mesh );
+}
+
+// Nodes are split by binned surface area heuristic: faces are distributed into bins by centers along every axis,
+// split between bins with the least sum of areas of parts multiplied by numbers of their faces is chosen
+void MeshTree::build( const std::vector<Box> &boxes )
+{
+    nodes.clear();
+    if( faces.empty() )
+        return;
+
+    std::vector<Vector3D> centers( boxes.size() );
+    for( size_t k = 0; k < boxes.size(); ++k )
+        centers[k] = ( boxes[k].low + boxes[k].high ) * 0.5;
+
+    struct Task
+    {
+        size_t node, begin, end;
+        int depth;
+    };
+
+    std::vector<Task> tasks{ { 0, 0, faces.size(), 0 } };
+    nodes.push_back( {} );
+
+    while( !tasks.empty() )
+    {
+        Task task = tasks.back();
+        tasks.pop_back();
+
+        Box box, centerBox;
+        for( size_t k = task.begin; k < task.end; ++k )
+        {
+            box.add( boxes[faces[k]] );
+            centerBox.add( centers[faces[k]] );
+        }
+        nodes[task.node].box = box;
+
+        size_t count = task.end - task.begin;
+        if( count <= MESH_TREE_LEAF || task.depth >= MESH_TREE_DEPTH - 1 )
+        {
+            nodes[task.node].first = task.begin;
+            nodes[task.node].count = count;
+            continue;
+        }
+
+        int bestAxis = -1, bestBin = 0;
+        double bestCost = std::numeric_limits<double>::infinity();
+        auto binOf = [&]( size_t f, int axis, double low, double scale )
+        {
+            return Min( int( ( axisOf( centers[f], axis ) - low ) * scale ), MESH_TREE_BINS - 1 );
+        };
+
+        for( int axis = 0; axis < 3; ++axis )
+        {
+            double low = axisOf( centerBox.low, axis ), high = axisOf( centerBox.high, axis );
+            if( !( high > low ) )
+                continue;
+
+            double scale = MESH_TREE_BINS / ( high - low );
+            Box bins[MESH_TREE_BINS];
+            size_t counts[MESH_TREE_BINS] = {};
+            for( size_t k = task.begin; k < task.end; ++k )
+            {
+                int bin = binOf( faces[k], axis, low, scale );
+                ++counts[bin];
+                bins[bin].add( boxes[faces[k]] );
+            }
+
+            // Left part of split 'b' holds bins [0, b)
+            double leftArea[MESH_TREE_BINS];
+            size_t leftCount[MESH_TREE_BINS];
+            Box part;
+            size_t number = 0;
+            for( int b = 1; b < MESH_TREE_BINS; ++b )
+            {
+                part.add( bins[b - 1] );
+                number += counts[b - 1];
+                leftArea[b] = part.area();
+                leftCount[b] = number;
+            }
+
+            part = Box();
+            number = 0;
+            for( int b = MESH_TREE_BINS - 1; b > 0; --b )
+            {
+                part.add( bins[b] );
+                number += counts[b];
+                if( leftCount[b] == 0 || number == 0 )
+                    continue;
+
+                double cost = leftArea[b] * leftCount[b] + part.area() * number;
+                if( cost < bestCost )
+                {
+                    bestCost = cost;
+                    bestAxis = axis;
+                    bestBin = b;
+                }
+            }
+        }
+
+        size_t middle;
+        if( bestAxis >= 0 )
+        {
+            double low = axisOf( centerBox.low, bestAxis ), scale = MESH_TREE_BINS / ( axisOf( centerBox.high, bestAxis ) - low );
+            middle = std::partition( faces.begin() + task.begin, faces.begin() + task.end, [&]( size_t f )
+            {
+                return binOf( f, bestAxis, low, scale ) < bestBin;
+            } ) - faces.begin();
+        }
+        else
+        {
+            // Centers of all faces coincide, any split is as good as another
+            middle = task.begin + count / 2;
+        }
+
+        size_t left = nodes.size();
+        nodes.push_back( {} );
+        nodes.push_back( {} );
+        nodes[task.node].first = left;
+        nodes[task.node].count = 0;
+
+        tasks.push_back( { left, task.begin, middle, task.depth + 1 } );
+        tasks.push_back( { left + 1, middle, task.end, task.depth + 1 } );
+    }
+}
+
+void MeshTree::fill( const Mesh &mesh )
+{
+    auto &points = mesh.getPoints();
+    auto &edges = mesh.getEdges();
+    auto &meshFaces = mesh.getFaces();
+
+    indices.resize( 3 * faces.size() );
+    corners.resize( 3 * faces.size() );
+    for( size_t k = 0; k < faces.size(); ++k )
+    {
+        auto &f = meshFaces[faces[k]];
+        indices[3 * k] = edges[f.p.a].s;
+        indices[3 * k + 1] = edges[f.p.b].s;
+        indices[3 * k + 2] = edges[f.p.c].s;
+        for( size_t c = 3 * k; c < 3 * k + 3; ++c )
+            corners[c] = points[indices[c]];
+    }
+
+    connect();
+    computeNormals( points.size() );
+}
+
+// Sides of faces are sorted by their ends, faces with the same side become neighbours
+// Side, that more than two faces share, links them to the first of those faces
+void MeshTree::connect()
+{
+    struct Side
+    {
+        size_t a, b, position;
+
+        bool operator<( const Side &other ) const
+        {
+            return a < other.a || ( a == other.a && ( b < other.b || ( b == other.b && position < other.position ) ) );
+        }
+    };
+
+    std::vector<Side> sides( indices.size() );
+    for( size_t k = 0; k < faces.size(); ++k )
+    {
+        for( size_t e = 0; e < 3; ++e )
+        {
+            size_t a = indices[3 * k + e], b = indices[3 * k + ( e + 1 ) % 3];
+            sides[3 * k + e] = { Min( a, b ), Max( a, b ), 3 * k + e };
+        }
+    }
+    std::sort( sides.begin(), sides.end() );
+
+    neighbours.assign( indices.size(), faces.size() );
+    for( size_t i = 0; i < sides.size(); )
+    {
+        size_t j = i + 1;
+        while( j < sides.size() && sides[j].a == sides[i].a && sides[j].b == sides[i].b )
+            ++j;
+
+        if( j - i >= 2 )
+        {
+            neighbours[sides[i].position] = sides[i + 1].position / 3;
+            for( size_t m = i + 1; m < j; ++m )
+                neighbours[sides[m].position] = sides[i].position / 3;
+        }
+        i = j;
+    }
+}
+
+void MeshTree::computeNormals( size_t points )
+{
+    pointNormals.assign( points, Vector3D() );
+    for( size_t k = 0; k < faces.size(); ++k )
+    {
+        Vector3D n = normal( k );
+        for( size_t c = 0; c < 3; ++c )
+        {
+            const Vector3D &p = corners[3 * k + c];
+            Vector3D a = corners[3 * k + ( c + 1 ) % 3] - p, b = corners[3 * k + ( c + 2 ) % 3] - p;
+
+            // Unlike arccosine, arctangent stays exact for nearly collinear sides
+            double angle = ArcTan2( a.M( b ).Abs(), a * b );
+            pointNormals[indices[3 * k + c]] += n * angle;
+        }
+    }
+}
+
+Vector3D MeshTree::normal( size_t k ) const
+{
+    const Vector3D *c = &corners[3 * k];
+    return ( c[1] - c[0] ).M( c[2] - c[0] ).Normal();
+}
+
+// Regions of plane of triangle are checked by dot products, as in "Real-Time Collision Detection" by C. Ericson
+Vector3D MeshTree::nearest( size_t k, const Vector3D &p, double &u, double &v, int &feature ) const
+{
+    const Vector3D &a = corners[3 * k], &b = corners[3 * k + 1], &c = corners[3 * k + 2];
+    Vector3D ab = b - a, ac = c - a, ap = p - a;
+
+    double d1 = ab * ap, d2 = ac * ap;
+    if( d1 <= 0 && d2 <= 0 )
+    {
+        u = v = 0;
+        feature = 1;
+        return a;
+    }
+
+    Vector3D bp = p - b;
+    double d3 = ab * bp, d4 = ac * bp;
+    if( d3 >= 0 && d4 <= d3 )
+    {
+        u = 1;
+        v = 0;
+        feature = 2;
+        return b;
+    }
+
+    double vc = d1 * d4 - d3 * d2;
+    if( vc <= 0 && d1 >= 0 && d3 <= 0 )
+    {
+        u = d1 - d3 > 0 ? d1 / ( d1 - d3 ) : 0;
+        v = 0;
+        feature = 4;
+        return a + ab * u;
+    }
+
+    Vector3D cp = p - c;
+    double d5 = ab * cp, d6 = ac * cp;
+    if( d6 >= 0 && d5 <= d6 )
+    {
+        u = 0;
+        v = 1;
+        feature = 3;
+        return c;
+    }
+
+    double vb = d5 * d2 - d1 * d6;
+    if( vb <= 0 && d2 >= 0 && d6 <= 0 )
+    {
+        u = 0;
+        v = d2 - d6 > 0 ? d2 / ( d2 - d6 ) : 0;
+        feature = 6;
+        return a + ac * v;
+    }
+
+    double va = d3 * d6 - d5 * d4;
+    if( va <= 0 && d4 - d3 >= 0 && d5 - d6 >= 0 )
+    {
+        double w = d4 - d3 + d5 - d6 > 0 ? ( d4 - d3 ) / ( d4 - d3 + d5 - d6 ) : 0;
+        u = 1 - w;
+        v = w;
+        feature = 5;
+        return b + ( c - b ) * w;
+    }
+
+    double denominator = va + vb + vc;
+    if( denominator > 0 )
+    {
+        u = vb / denominator;
+        v = vc / denominator;
+        feature = 0;
+        return a + ab * u + ac * v;
+    }
+
+    // Degenerate face, that rounding kept out of regions of corners and edges: the nearest of its sides is taken
+    double best = std::numeric_limits<double>::infinity();
+    Vector3D result = a;
+    for( int e = 0; e < 3; ++e )
+    {
+        const Vector3D &s = corners[3 * k + e], &f = corners[3 * k + ( e + 1 ) % 3];
+        Vector3D side = f - s;
+        double length = side.Sqr(), w = length > 0 ? Min( Max( ( p - s ) * side / length, 0.0 ), 1.0 ) : 0;
+        Vector3D q = s + side * w;
+        if( ( q - p ).Sqr() < best )
+        {
+            best = ( q - p ).Sqr();
+            result = q;
+            feature = 4 + e;
+            u = e == 0 ? w : ( e == 1 ? 1 - w : 0 );
+            v = e == 0 ? 0 : ( e == 1 ? w : 1 - w );
+        }
+    }
+    return result;
+}
+
+void MeshTree::refit( const Mesh &mesh )
+{
+    // Mesh must have the same faces, as mesh of tree
+    makeException( mesh.getFaces().size() == faces.size() );
+
+    auto &points = mesh.getPoints();
+    for( size_t c = 0; c < corners.size(); ++c )
+        corners[c] = points[indices[c]];
+    computeNormals( points.size() );
+
+    // Children are always after their parents
+    for( size_t n = nodes.size(); n-- > 0; )
+    {
+        Node &node = nodes[n];
+        node.box = Box();
+        if( node.count > 0 )
+        {
+            for( size_t k = node.first; k < node.first + node.count; ++k )
+            {
+                Box face;
+                face.add( corners[3 * k] );
+                face.add( corners[3 * k + 1] );
+                face.add( corners[3 * k + 2] );
+                pad( face );
+                node.box.add( face );
+            }
+        }
+        else
+        {
+            node.box.add( nodes[node.first].box );
+            node.box.add( nodes[node.first + 1].box );
+        }
+    }
+}
+
+const std::vector<MeshTree::Node> &MeshTree::getNodes() const
+{
+    return nodes;
+}
+
+size_t MeshTree::size() const
+{
+    return faces.size();
+}
+
+size_t MeshTree::face( size_t k ) const
+{
+    return faces[k];
+}
+
+const Vector3D *MeshTree::corner( size_t k ) const
+{
+    return &corners[3 * k];
+}
+
+// Children, that line crosses before the nearest found face, are visited, the nearer one first
+// Faces with equal parameters are resolved in favour of the lower index, same as in order of mesh
+void MeshTree::trace( const Vector3D &p0, const Vector3D &p1, bool any, Mesh::Hit &hit ) const
+{
+    hit = Mesh::Hit{ {}, 0, 0, 0 };
+    if( nodes.empty() )
+        return;
+
+    // Any hit only accepts faces between ends of segment
+    Vector3D direction = p1 - p0, inverse( 1.0 / direction.x, 1.0 / direction.y, 1.0 / direction.z );
+    double u0, v0, t0, tMin = any ? 1.0 : std::numeric_limits<double>::max(), near, far;
+    if( !intersectLineBox( nodes[0].box, p0, direction, inverse, near, far ) || ( any && far < 0 ) )
+        return;
+
+    size_t stack[MESH_TREE_DEPTH];
+    double nears[MESH_TREE_DEPTH];
+    int top = 0;
+    stack[top] = 0;
+    nears[top++] = near;
+
+    while( top > 0 )
+    {
+        --top;
+        if( nears[top] > tMin )
+            continue;
+
+        const Node &node = nodes[stack[top]];
+        if( node.count > 0 )
+        {
+            for( size_t k = node.first; k < node.first + node.count; ++k )
+            {
+                const Vector3D *c = &corners[3 * k];
+                if( !intersectSegmentTriangle( p0, p1, c[0], c[1], c[2], u0, v0, t0 ) )
+                    continue;
+
+                if( any )
+                {
+                    if( t0 < 0 || t0 > 1 )
+                        continue;
+
+                    hit = Mesh::Hit{ faces[k], u0, v0, t0 };
+                    return;
+                }
+
+                if( t0 < tMin || ( t0 == tMin && hit.face && faces[k] < *hit.face ) )
+                {
+                    hit = Mesh::Hit{ faces[k], u0, v0, t0 };
+                    tMin = t0;
+                }
+            }
+            continue;
+        }
+
+        double nearA, nearB, farA, farB;
+        bool a = intersectLineBox( nodes[node.first].box, p0, direction, inverse, nearA, farA ) && nearA <= tMin && ( !any || farA >= 0 );
+        bool b = intersectLineBox( nodes[node.first + 1].box, p0, direction, inverse, nearB, farB ) && nearB <= tMin && ( !any || farB >= 0 );
+
+        // Stack is popped from the end, so the nearer child is pushed last
+        if( a && b && nearA <= nearB )
+        {
+            stack[top] = node.first + 1;
+            nears[top++] = nearB;
+            b = false;
+        }
+        if( b )
+        {
+            stack[top] = node.first + 1;
+            nears[top++] = nearB;
+        }
+        if( a )
+        {
+            stack[top] = node.first;
+            nears[top++] = nearA;
+        }
+    }
+}
+
+std::optional<size_t> MeshTree::intersectSegment( const Vector3D &p0, const Vector3D &p1, double &u, double &v, double &t ) const
+{
+    Mesh::Hit hit;
+    trace( p0, p1, false, hit );
+    if( hit.face )
+    {
+        u = hit.u;
+        v = hit.v;
+        t = hit.t;
+    }
+    return hit.face;
+}
+
+// Spreads 10 bits of 'v' to every third bit
+static uint32_t spreadBits( uint32_t v )
+{
+    v = ( v | ( v << 16 ) ) & 0x030000FF;
+    v = ( v | ( v << 8 ) ) & 0x0300F00F;
+    v = ( v | ( v << 4 ) ) & 0x030C30C3;
+    v = ( v | ( v << 2 ) ) & 0x09249249;
+    return v;
+}
+
+void MeshTree::intersectSegments( const Vector3D *p0, const Vector3D *p1, size_t count, Mesh::Hit *hits, bool any ) const
+{
+    if( nodes.empty() )
+    {
+        for( size_t k = 0; k < count; ++k )
+            hits[k] = Mesh::Hit{ {}, 0, 0, 0 };
+        return;
+    }
+
+    // Octant of direction is above Morton code of start, that is quantized in box of tree
+    const Box &root = nodes[0].box;
+    Vector3D size = root.high - root.low;
+    auto quantize = [&]( double x, double low, double extent )
+    {
+        double q = extent > 0 ? ( x - low ) / extent * 1023 : 0;
+        return uint32_t( q > 0 ? Min( q, 1023.0 ) : 0.0 );
+    };
+
+    std::vector<std::pair<uint64_t, size_t>> keys( count );
+    parallelFor( count, [&]( size_t begin, size_t end )
+    {
+        for( size_t k = begin; k < end; ++k )
+        {
+            Vector3D d = p1[k] - p0[k];
+            uint64_t octant = ( d.x < 0 ? 1 : 0 ) | ( d.y < 0 ? 2 : 0 ) | ( d.z < 0 ? 4 : 0 );
+            uint32_t morton = spreadBits( quantize( p0[k].x, root.low.x, size.x ) ) |
+                              spreadBits( quantize( p0[k].y, root.low.y, size.y ) ) << 1 |
+                              spreadBits( quantize( p0[k].z, root.low.z, size.z ) ) << 2;
+            keys[k] = { octant << 32 | morton, k };
+        }
+    }, MESH_TREE_GRANULE );
+    std::sort( keys.begin(), keys.end() );
+
+    // Neighbouring segments in sorted order visit mostly the same nodes, which stay in cache
+    parallelFor( count, [&]( size_t begin, size_t end )
+    {
+        for( size_t k = begin; k < end; ++k )
+        {
+            size_t id = keys[k].second;
+            trace( p0[id], p1[id], any, hits[id] );
+        }
+    }, MESH_TREE_GRANULE );
+}
+
+template<typename D, typename L, typename V>
+void MeshTree::search( D distance, L limit, V visit ) const
+{
+    if( nodes.empty() )
+        return;
+
+    size_t stack[MESH_TREE_DEPTH];
+    double bounds[MESH_TREE_DEPTH];
+    int top = 0;
+    stack[top] = 0;
+    bounds[top++] = distance( nodes[0].box );
+
+    while( top > 0 )
+    {
+        --top;
+        if( bounds[top] > limit() )
+            continue;
+
+        const Node &node = nodes[stack[top]];
+        if( node.count > 0 )
+        {
+            for( size_t k = node.first; k < node.first + node.count; ++k )
+                visit( k );
+            continue;
+        }
+
+        double a = distance( nodes[node.first].box ), b = distance( nodes[node.first + 1].box );
+        size_t near = a <= b ? node.first : node.first + 1;
+        if( Max( a, b ) <= limit() )
+        {
+            stack[top] = near == node.first ? node.first + 1 : node.first;
+            bounds[top++] = Max( a, b );
+        }
+        if( Min( a, b ) <= limit() )
+        {
+            stack[top] = near;
+            bounds[top++] = Min( a, b );
+        }
+    }
+}
+
+Mesh::Nearest MeshTree::closest( const Vector3D &p, int &feature, size_t &position ) const
+{
+    Mesh::Nearest result{ {}, 0, 0, Vector3D(), std::numeric_limits<double>::infinity() };
+    double best = std::numeric_limits<double>::infinity();
+
+    search( [&]( const Box &box )
+    {
+        return boxDistance( box, p );
+    }, [&]()
+    {
+        return best;
+    }, [&]( size_t k )
+    {
+        double u, v;
+        int f;
+        Vector3D q = nearest( k, p, u, v, f );
+        double d = ( q - p ).Sqr();
+        if( d < best || ( d == best && result.face && faces[k] < *result.face ) )
+        {
+            best = d;
+            result = Mesh::Nearest{ faces[k], u, v, q, 0 };
+            feature = f;
+            position = k;
+        }
+    } );
+
+    result.distance = Sqrt( best );
+    return result;
+}
+
+Mesh::Nearest MeshTree::closestPoint( const Vector3D &p ) const
+{
+    int feature;
+    size_t position;
+    return closest( p, feature, position );
+}
+
+// Pseudo-normal of face is its normal, of edge is sum of normals of faces on its sides, of corner is sum of normals around it
+// weighted by angles, as in "Signed distance computation using the angle weighted pseudonormal" by J. A. Baerentzen and H. Aanaes
+double MeshTree::signedDistance( const Vector3D &p ) const
+{
+    int feature = 0;
+    size_t k = 0;
+    auto result = closest( p, feature, k );
+    if( !result.face )
+        return result.distance;
+
+    Vector3D pseudo;
+    if( feature == 0 )
+    {
+        pseudo = normal( k );
+    }
+    else if( feature <= 3 )
+    {
+        pseudo = pointNormals[indices[3 * k + feature - 1]];
+    }
+    else
+    {
+        pseudo = normal( k );
+        size_t other = neighbours[3 * k + feature - 4];
+        if( other < faces.size() )
+            pseudo += normal( other );
+    }
+
+    return ( p - result.point ) * pseudo < 0 ? -result.distance : result.distance;
+}
+
+std::vector<size_t> MeshTree::nearestPoints( const Vector3D &p, size_t k ) const
+{
+    // Squared distances and points, ordered by them, then by points
+    std::vector<std::pair<double, size_t>> best;
+    if( k == 0 )
+        return {};
+
+    search( [&]( const Box &box )
+    {
+        return boxDistance( box, p );
+    }, [&]()
+    {
+        return best.size() < k ? std::numeric_limits<double>::infinity() : best.back().first;
+    }, [&]( size_t f )
+    {
+        for( size_t c = 3 * f; c < 3 * f + 3; ++c )
+        {
+            std::pair<double, size_t> candidate( ( corners[c] - p ).Sqr(), indices[c] );
+            if( best.size() == k && !( candidate < best.back() ) )
+                continue;
+
+            auto position = std::lower_bound( best.begin(), best.end(), candidate );
+            if( position != best.end() && *position == candidate )
+                continue;
+
+            best.insert( position, candidate );
+            if( best.size() > k )
+                best.pop_back();
+        }
+    } );
+
+    std::vector<size_t> result( best.size() );
+    for( size_t i = 0; i < best.size(); ++i )
+        result[i] = best[i].second;
+    return result;
+}
+
+std::vector<size_t> MeshTree::facesWithin( const Vector3D &p, double radius ) const
+{
+    std::vector<size_t> result;
+    double limit = radius * radius;
+
+    search( [&]( const Box &box )
+    {
+        return boxDistance( box, p );
+    }, [&]()
+    {
+        return limit;
+    }, [&]( size_t k )
+    {
+        double u, v;
+        int feature;
+        if( ( nearest( k, p, u, v, feature ) - p ).Sqr() <= limit )
+            result.push_back( faces[k] );
+    } );
+
+    std::sort( result.begin(), result.end() );
+    return result;
+}
+
+std::vector<size_t> MeshTree::facesInBox( const Vector3D &low, const Vector3D &high ) const
+{
+    std::vector<size_t> result;
+    Vector3D center = ( low + high ) * 0.5, half = ( high - low ) * 0.5;
+
+    // Boxes, that don't overlap query, are infinitely far
+    search( [&]( const Box &box )
+    {
+        bool overlap = box.low.x <= high.x && box.high.x >= low.x &&
+                       box.low.y <= high.y && box.high.y >= low.y &&
+                       box.low.z <= high.z && box.high.z >= low.z;
+        return overlap ? 0.0 : std::numeric_limits<double>::infinity();
+    }, []()
+    {
+        return 0.0;
+    }, [&]( size_t k )
+    {
+        if( overlapBoxTriangle( center, half, &corners[3 * k] ) )
+            result.push_back( faces[k] );
+    } );
+
+    std::sort( result.begin(), result.end() );
+    return result;
+}
+
+void MeshTree::closestPoints( const Vector3D *p, size_t count, Mesh::Nearest *results ) const
+{
+    parallelFor( count, [&]( size_t begin, size_t end )
+    {
+        for( size_t k = begin; k < end; ++k )
+            results[k] = closestPoint( p[k] );
+    }, MESH_TREE_GRANULE );
+}
+
+void MeshTree::signedDistances( const Vector3D *p, size_t count, double *results ) const
+{
+    parallelFor( count, [&]( size_t begin, size_t end )
+    {
+        for( size_t k = begin; k < end; ++k )
+            results[k] = signedDistance( p[k] );
+    }, MESH_TREE_GRANULE );
+}
+
+bool intersectSegmentTriangle(
+    const Vector3D &p0, const Vector3D &p1,
+    const Vector3D &v0, const Vector3D &v1, const Vector3D &v2,
+    double &u, double &v, double &t
+)
+{
+    auto dir = p1 - p0;
+    auto edge1 = v1 - v0;
+    auto edge2 = v2 - v0;
+
+    if( dir * edge1.M( edge2 ) >= 0 )
+        return false; // Hits a face from the back
+
+    // Möller–Trumbore intersection
+
+    auto pvec = dir.M( edge2 );
+    double det = edge1 * pvec;
+    if( Abs( det ) < Vector3D::epsilon )
+        return false; // Parallel or degenerate
+
+    double invDet = 1.0 / det;
+
+    auto tvec = p0 - v0;
+    auto qvec = tvec.M( edge1 );
+
+    u = ( tvec * pvec ) * invDet;
+    v = ( dir * qvec ) * invDet;
+    t = ( edge2 * qvec ) * invDet;
+
+    return u >= 0.0 && v >= 0.0 && u + v <= 1.0;
+}
+
+bool intersectLineBox( const MeshTree::Box &box, const Vector3D &origin, const Vector3D &direction, const Vector3D &inverse, double &near, double &far )
+{
+    near = -std::numeric_limits<double>::infinity();
+    far = std::numeric_limits<double>::infinity();
+
+    for( int axis = 0; axis < 3; ++axis )
+    {
+        double o = axisOf( origin, axis ), low = axisOf( box.low, axis ), high = axisOf( box.high, axis );
+        if( axisOf( direction, axis ) == 0 )
+        {
+            // Line is parallel to slab
+            if( o < low || o > high )
+                return false;
+            continue;
+        }
+
+        double r = axisOf( inverse, axis ), t0 = ( low - o ) * r, t1 = ( high - o ) * r;
+        if( t0 > t1 )
+            std::swap( t0, t1 );
+        near = Max( near, t0 );
+        far = Min( far, t1 );
+    }
+
+    // Every parameter has error of a few units in the last place
+    const double error = 4 * std::numeric_limits<double>::epsilon();
+    near -= Abs( near ) * error;
+    far += Abs( far ) * error;
+    return near <= far;
+}
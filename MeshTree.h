@@ -0,0 +1,131 @@
+#pragma once
+
+#include <optional>
+#include <vector>
+
+#include "Vector3D.h"
+#include "Mesh.h"
+
+// Depth, that hierarchy doesn't exceed, so traversal keeps its stack in fixed array
+#define MESH_TREE_DEPTH 64
+
+// Faces, that leaf holds at most
+#define MESH_TREE_LEAF 4
+
+// Intervals along axis, between which splits are searched
+#define MESH_TREE_BINS 16
+
+// Segments or points, that one thread gets at least in batched queries
+#define MESH_TREE_GRANULE 256
+
+// Bounding volume hierarchy over faces of mesh, nodes are split, where surface area heuristic is the least
+// Corners of faces are copied in order of leaves, so traversal reads them contiguously without lookups in mesh
+// Tree is constant after construction, so it can be shared between threads
+class MeshTree
+{
+public:
+    struct Box
+    {
+        Vector3D low, high;
+
+        Box();
+
+        void add( const Vector3D &p );
+        void add( const Box &b );
+
+        bool empty() const;
+        double area() const;
+    };
+
+    // Leaf holds faces [first, first + count) in order of tree, other nodes have count 0 and children first and first + 1
+    struct Node
+    {
+        Box box;
+        size_t first, count;
+    };
+private:
+    std::vector<Node> nodes;
+
+    // Face of mesh and positions of its corners in points for every face in order of tree
+    std::vector<size_t> faces;
+    std::vector<size_t> indices;
+    std::vector<Vector3D> corners;
+
+    // Positions in order of tree of faces across edges ab, bc, ca of every face, size of 'faces' for border edges
+    std::vector<size_t> neighbours;
+
+    // Angle-weighted sums of normals of faces around every point of mesh
+    std::vector<Vector3D> pointNormals;
+
+    void build( const std::vector<Box> &boxes );
+    void fill( const Mesh &mesh );
+    void connect();
+    void computeNormals( size_t points );
+
+    // Normal of face at position 'k' in order of tree, zero for degenerate faces
+    Vector3D normal( size_t k ) const;
+
+    // Nearest point of face at position 'k', 'feature' is 0 inside of face, 1 + corner for corners and 4 + edge for edges
+    Vector3D nearest( size_t k, const Vector3D &p, double &u, double &v, int &feature ) const;
+
+    // Visits tree depth-first, nearer child first: 'distance( box )' is the least distance to faces in box,
+    // nodes farther than 'limit()' are skipped, 'visit( k )' is called for faces in leaves at positions 'k'
+    template<typename D, typename L, typename V>
+    void search( D distance, L limit, V visit ) const;
+
+    Mesh::Nearest closest( const Vector3D &p, int &feature, size_t &position ) const;
+    // Finds the nearest hit of line or, with 'any', the first found hit between ends of segment
+    void trace( const Vector3D &p0, const Vector3D &p1, bool any, Mesh::Hit &hit ) const;
+public:
+    explicit MeshTree( const Mesh &mesh );
+
+    // Recomputes corners and boxes from points of 'mesh', which must have the same faces, as mesh of tree
+    // Splits stay, so tree stays correct, but becomes slower, if points move relative to each other
+    void refit( const Mesh &mesh );
+
+    const std::vector<Node> &getNodes() const;
+
+    // Number of faces
+    size_t size() const;
+
+    // Face of mesh at position 'k' in order of tree
+    size_t face( size_t k ) const;
+
+    // Three corners of face at position 'k' in order of tree
+    const Vector3D *corner( size_t k ) const;
+
+    // Same as Mesh::intersectSegment
+    std::optional<size_t> intersectSegment( const Vector3D &p0, const Vector3D &p1, double &u, double &v, double &t ) const;
+
+    // Same as Mesh::closestPoint, Mesh::signedDistance, Mesh::nearestPoints, Mesh::facesWithin, Mesh::facesInBox
+    Mesh::Nearest closestPoint( const Vector3D &p ) const;
+    double signedDistance( const Vector3D &p ) const;
+    std::vector<size_t> nearestPoints( const Vector3D &p, size_t k ) const;
+    std::vector<size_t> facesWithin( const Vector3D &p, double radius ) const;
+    std::vector<size_t> facesInBox( const Vector3D &low, const Vector3D &high ) const;
+
+    // Same as Mesh::closestPoints and Mesh::signedDistances
+    void closestPoints( const Vector3D *p, size_t count, Mesh::Nearest *results ) const;
+    void signedDistances( const Vector3D *p, size_t count, double *results ) const;
+
+    // Same as Mesh::intersectSegments
+    // Segments are sorted by octant of direction and by position of start along Morton curve,
+    // so segments, that are traced one after another, visit mostly the same nodes
+    void intersectSegments( const Vector3D *p0, const Vector3D *p1, size_t count, Mesh::Hit *hits, bool any ) const;
+};
+
+// Line p0, p1
+// Triangle v0, v1, v2
+// The intersection point p
+// Parameter t along line segment: p = p0 + t( p1 - p0 )
+// Barycentric coordinates u, v in triangle: p = v0 + u( v1 - v0 ) + v( v2 - v0 )
+// Returns true, if p lies within the triangle and line hits triangle from the front
+bool intersectSegmentTriangle(
+    const Vector3D &p0, const Vector3D &p1,
+    const Vector3D &v0, const Vector3D &v1, const Vector3D &v2,
+    double &u, double &v, double &t
+);
+
+// Finds parameters of line p = origin + t * direction, at which it enters and leaves box, 'inverse' holds 1 / direction
+// Returns false, if line misses box, bounds are widened by rounding errors, so faces on border aren't missed
+bool intersectLineBox( const MeshTree::Box &box, const Vector3D &origin, const Vector3D &direction, const Vector3D &inverse, double &near, double &far );
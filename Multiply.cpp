@@ -0,0 +1 @@
+#include "Multiply.h"
@@ -0,0 +1,208 @@
+#pragma once
+
+#include <type_traits>
+#include <vector>
+
+#include "Exception.h"
+#include "Parallel.h"
+#include "Matrix.h"
+#include "Basic.h"
+
+// Products with less multiplications than this are computed directly, without packing
+#define MULTIPLY_DIRECT 32768
+
+// Block of left matrix: lines, that one thread packs, and length of common dimension, that stays in cache
+#define MULTIPLY_LINES 96
+#define MULTIPLY_DEPTH 256
+
+// Block of right matrix, that is packed once and shared by all threads
+#define MULTIPLY_COLUMNS 2048
+
+// Packing and micro-kernel of blocked multiplication
+template<typename T>
+struct MultiplyBlock
+{
+    // Size of block of result, that micro-kernel accumulates, every line of it is a separate array, that compilers vectorize
+    static const int lines = 4;
+    static const int columns = sizeof( T ) < 4 ? 16 : 64 / sizeof( T );
+
+    // Copies 'count' lines of 'a' from 'line', 'depth' values from 'offset', into panels of 'lines' lines
+    // Panel stores column after column, missing lines are zero
+    static void packLeft( const MatrixBase<T> &a, int line, int count, int offset, int depth, T *result )
+    {
+        for( int panel = 0; panel < count; panel += lines )
+        {
+            const T *source[lines];
+            for( int r = 0; r < lines; ++r )
+                source[r] = panel + r < count ? a( offset, line + panel + r ) : nullptr;
+
+            for( int p = 0; p < depth; ++p )
+            {
+                for( int r = 0; r < lines; ++r )
+                    result[r] = source[r] ? source[r][p] : T();
+                result += lines;
+            }
+        }
+    }
+
+    // Copies 'depth' lines of 'b' from 'offset', 'count' values from 'column', into panels of 'columns' columns
+    // Panel stores line after line, missing columns are zero
+    static void packRight( const MatrixBase<T> &b, int offset, int depth, int column, int count, T *result )
+    {
+        for( int panel = 0; panel < count; panel += columns )
+        {
+            int width = Min( count - panel, columns );
+            for( int p = 0; p < depth; ++p )
+            {
+                const T *source = b( column + panel, offset + p );
+                int c = 0;
+                for( ; c < width; ++c )
+                    result[c] = source[c];
+                for( ; c < columns; ++c )
+                    result[c] = T();
+                result += columns;
+            }
+        }
+    }
+
+    // Adds product of packed panels to block of 'height' x 'width' values of result, that starts at 'target'
+    // Every line of 'target' is 'stride' values after previous one
+    static void kernel( int depth, const T *a, const T *b, T *target, int stride, int height, int width )
+    {
+        T sum0[columns] = {}, sum1[columns] = {}, sum2[columns] = {}, sum3[columns] = {};
+        for( int p = 0; p < depth; ++p )
+        {
+            T a0 = a[0], a1 = a[1], a2 = a[2], a3 = a[3];
+            for( int c = 0; c < columns; ++c )
+            {
+                sum0[c] += a0 * b[c];
+                sum1[c] += a1 * b[c];
+                sum2[c] += a2 * b[c];
+                sum3[c] += a3 * b[c];
+            }
+            a += lines;
+            b += columns;
+        }
+        T *sum[lines] = { sum0, sum1, sum2, sum3 };
+
+        if( height == lines && width == columns )
+        {
+            for( int r = 0; r < lines; ++r )
+            {
+                for( int c = 0; c < columns; ++c )
+                    target[r * stride + c] += sum[r][c];
+            }
+            return;
+        }
+
+        for( int r = 0; r < height; ++r )
+        {
+            for( int c = 0; c < width; ++c )
+                target[r * stride + c] += sum[r][c];
+        }
+    }
+};
+
+// Computes result = a * b, 'result' must not be 'a' or 'b'
+// Arithmetic types are multiplied by blocks, that are packed into contiguous panels, lines of result are split between threads
+// Other types are multiplied directly, line of 'a' by lines of 'b'
+template<typename T>
+void multiply( const MatrixBase<T> &a, const MatrixBase<T> &b, MatrixBase<T> &result )
+{
+    // Matrix dimensions must match for multiplication
+    makeException( a.w() == b.h() );
+
+    // Result must be a separate matrix
+    makeException( &result != &a && &result != &b );
+
+    int height = a.h(), width = b.w(), depth = a.w();
+    if( result.w() != width || result.h() != height )
+        result.reset( width, height );
+    if( result.empty() )
+        return;
+
+    for( int i = 0; i < height; ++i )
+    {
+        T *line = result( 0, i );
+        for( int j = 0; j < width; ++j )
+            line[j] = T();
+    }
+
+    if( depth == 0 )
+        return;
+
+    bool direct = double( height ) * width * depth < MULTIPLY_DIRECT;
+    if constexpr( std::is_arithmetic_v<T> )
+    {
+        if( !direct )
+        {
+            using Block = MultiplyBlock<T>;
+            int blocks = ( height + MULTIPLY_LINES - 1 ) / MULTIPLY_LINES;
+            std::vector<T> right;
+
+            for( int column = 0; column < width; column += MULTIPLY_COLUMNS )
+            {
+                int columns = Min( width - column, MULTIPLY_COLUMNS );
+                int panels = ( columns + Block::columns - 1 ) / Block::columns;
+
+                for( int offset = 0; offset < depth; offset += MULTIPLY_DEPTH )
+                {
+                    int length = Min( depth - offset, MULTIPLY_DEPTH );
+
+                    right.resize( size_t( panels ) * Block::columns * length );
+                    parallelFor( panels, [&]( size_t begin, size_t end )
+                    {
+                        int first = begin * Block::columns, count = Min( int( end ) * Block::columns, columns ) - first;
+                        Block::packRight( b, offset, length, column + first, count, right.data() + size_t( first ) * length );
+                    } );
+
+                    parallelFor( blocks, [&]( size_t begin, size_t end )
+                    {
+                        std::vector<T> left( size_t( MULTIPLY_LINES ) * length );
+                        for( int block = begin; block < int( end ); ++block )
+                        {
+                            int line = block * MULTIPLY_LINES;
+                            int lines = Min( height - line, MULTIPLY_LINES );
+                            Block::packLeft( a, line, lines, offset, length, left.data() );
+
+                            for( int panel = 0; panel < panels; ++panel )
+                            {
+                                int j = panel * Block::columns;
+                                int w = Min( columns - j, Block::columns );
+                                const T *packed = right.data() + size_t( j ) * length;
+
+                                for( int r = 0; r < lines; r += Block::lines )
+                                {
+                                    int h = Min( lines - r, Block::lines );
+                                    Block::kernel( length, left.data() + size_t( r ) * length, packed,
+                                                   result( column + j, line + r ), result.s(), h, w );
+                                }
+                            }
+                        }
+                    } );
+                }
+            }
+            return;
+        }
+    }
+
+    auto lines = [&]( size_t begin, size_t end )
+    {
+        for( int i = begin; i < int( end ); ++i )
+        {
+            T *target = result( 0, i );
+            const T *source = a( 0, i );
+            for( int k = 0; k < depth; ++k )
+            {
+                const T *line = b( 0, k );
+                for( int j = 0; j < width; ++j )
+                    target[j] += source[k] * line[j];
+            }
+        }
+    };
+
+    if( direct )
+        lines( 0, height );
+    else
+        parallelFor( height, lines );
+}
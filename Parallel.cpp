@@ -0,0 +1,64 @@
+#include "Parallel.h"
+
+#include <exception>
+#include <thread>
+#include <vector>
+#include <mutex>
+
+unsigned parallelThreads()
+{
+    static const unsigned threads = std::thread::hardware_concurrency();
+    return threads > 0 ? threads : 1;
+}
+
+void parallelFor( size_t count, const std::function<void( size_t begin, size_t end )> &function, size_t granule )
+{
+    if( count <= 0 )
+        return;
+
+    if( granule <= 0 )
+        granule = 1;
+
+    size_t granules = ( count + granule - 1 ) / granule;
+    size_t parts = granules < parallelThreads() ? granules : parallelThreads();
+    if( parts <= 1 )
+    {
+        function( 0, count );
+        return;
+    }
+
+    std::exception_ptr error;
+    std::mutex mutex;
+
+    auto process = [&]( size_t part )
+    {
+        size_t begin = granules * part / parts * granule;
+        size_t end = granules * ( part + 1 ) / parts * granule;
+        if( end > count )
+            end = count;
+
+        try
+        {
+            function( begin, end );
+        }
+        catch( ... )
+        {
+            std::lock_guard<std::mutex> lock( mutex );
+            if( !error )
+                error = std::current_exception();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve( parts - 1 );
+    for( size_t part = 1; part < parts; ++part )
+        threads.emplace_back( process, part );
+
+    process( 0 );
+
+    for( auto &thread : threads )
+        thread.join();
+
+    if( error )
+        std::rethrow_exception( error );
+}
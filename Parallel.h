@@ -0,0 +1,11 @@
+#pragma once
+
+#include <functional>
+
+// Splits range [0, count) into contiguous parts and processes them on separate threads
+// Boundaries of parts are multiples of 'granule', calling thread processes the first part itself
+// Returns, when all parts are processed, rethrows first exception, that was thrown by any part
+void parallelFor( size_t count, const std::function<void( size_t begin, size_t end )> &function, size_t granule = 1 );
+
+// Number of threads parallelFor uses at most, at least 1
+unsigned parallelThreads();
@@ -0,0 +1 @@
+#include "Sparse.h"
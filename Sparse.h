@@ -0,0 +1,580 @@
+#pragma once
+
+#include <type_traits>
+#include <algorithm>
+#include <utility>
+#include <vector>
+#include <cmath>
+
+#include "Exception.h"
+#include "Parallel.h"
+#include "Matrix.h"
+#include "Basic.h"
+
+// Stored values, that one thread gets at least, when sparse matrix is multiplied by vector
+// Also values of vectors, that one thread gets at least, in operations of iterative solvers
+#define SPARSE_GRANULE 65536
+
+// Coordinate list, from which sparse matrix is built
+// Values are added in any order, values at the same position are summed
+template<typename T>
+struct SparseTriplets
+{
+    struct Triplet
+    {
+        int j, i;
+        T value;
+    };
+
+    int width, height;
+    std::vector<Triplet> values;
+
+    SparseTriplets( int w, int h ) : width( w ), height( h )
+    {
+        // Matrix dimensions must be non-negative
+        makeException( w >= 0 && h >= 0 );
+    }
+
+    // Adds 'value' to column 'j' in line 'i'
+    void add( int j, int i, const T &value )
+    {
+        // Position must be inside of matrix
+        makeException( 0 <= j && j < width && 0 <= i && i < height );
+
+        values.push_back( { j, i, value } );
+    }
+};
+
+// Sparse matrix in compressed lines: values of line 'i' and their columns are at [offsets[i], offsets[i + 1])
+// Columns in every line are sorted and unique
+// Lines of transposed matrix are columns of this one, so transpose() gives compressed columns, when they are needed
+template<typename T>
+class SparseMatrix
+{
+private:
+    int width, height;
+    std::vector<size_t> offsets;
+    std::vector<int> indices;
+    std::vector<T> data;
+
+    // Builds lines from triplets, that are sorted by line, then by column
+    void build( int w, int h, std::vector<typename SparseTriplets<T>::Triplet> &values )
+    {
+        std::sort( values.begin(), values.end(), []( const auto &a, const auto &b )
+        {
+            return a.i < b.i || ( a.i == b.i && a.j < b.j );
+        } );
+
+        width = w;
+        height = h;
+        offsets.assign( size_t( h ) + 1, 0 );
+        indices.clear();
+        data.clear();
+
+        for( size_t k = 0; k < values.size(); ++k )
+        {
+            auto &v = values[k];
+            if( k > 0 && v.i == values[k - 1].i && v.j == values[k - 1].j )
+            {
+                data.back() += v.value;
+                continue;
+            }
+
+            indices.push_back( v.j );
+            data.push_back( v.value );
+            ++offsets[v.i + 1];
+        }
+
+        for( int i = 0; i < h; ++i )
+            offsets[i + 1] += offsets[i];
+    }
+public:
+    SparseMatrix() : width( 0 ), height( 0 ), offsets( 1, 0 )
+    {}
+
+    explicit SparseMatrix( SparseTriplets<T> triplets )
+    {
+        build( triplets.width, triplets.height, triplets.values );
+    }
+
+    // Keeps values of dense matrix, that aren't zero
+    explicit SparseMatrix( const MatrixBase<T> &matrix )
+    {
+        std::vector<typename SparseTriplets<T>::Triplet> values;
+        for( int i = 0; i < matrix.h(); ++i )
+        {
+            const T *line = matrix( 0, i );
+            for( int j = 0; j < matrix.w(); ++j )
+            {
+                if( line[j] != T() )
+                    values.push_back( { j, i, line[j] } );
+            }
+        }
+        build( matrix.w(), matrix.h(), values );
+    }
+
+    int w() const
+    {
+        return width;
+    }
+
+    int h() const
+    {
+        return height;
+    }
+
+    // Number of stored values
+    size_t size() const
+    {
+        return data.size();
+    }
+
+    // Stored values of line 'i' are at [begin( i ), end( i ) )
+    size_t begin( int i ) const
+    {
+        return offsets[i];
+    }
+
+    size_t end( int i ) const
+    {
+        return offsets[i + 1];
+    }
+
+    // Column of stored value 'k'
+    int column( size_t k ) const
+    {
+        return indices[k];
+    }
+
+    const T &value( size_t k ) const
+    {
+        return data[k];
+    }
+
+    T &value( size_t k )
+    {
+        return data[k];
+    }
+
+    // Stored value of column 'j' in line 'i', nullptr, if value isn't stored or position is outside of matrix
+    const T *operator()( int j, int i ) const
+    {
+        if( i < 0 || i >= height )
+            return nullptr;
+
+        auto first = indices.begin() + offsets[i], last = indices.begin() + offsets[i + 1];
+        auto found = std::lower_bound( first, last, j );
+        if( found == last || *found != j )
+            return nullptr;
+        return &data[found - indices.begin()];
+    }
+
+    T *operator()( int j, int i )
+    {
+        return const_cast<T *>( static_cast<const SparseMatrix &>( *this )( j, i ) );
+    }
+
+    SparseMatrix transpose() const
+    {
+        SparseMatrix result;
+        result.width = height;
+        result.height = width;
+        result.offsets.assign( size_t( width ) + 1, 0 );
+        result.indices.resize( data.size() );
+        result.data.resize( data.size() );
+
+        for( int column : indices )
+            ++result.offsets[column + 1];
+        for( int i = 0; i < width; ++i )
+            result.offsets[i + 1] += result.offsets[i];
+
+        // Lines are traversed in order, so columns of transposed lines stay sorted
+        std::vector<size_t> next( result.offsets.begin(), result.offsets.end() - 1 );
+        for( int i = 0; i < height; ++i )
+        {
+            for( size_t k = offsets[i]; k < offsets[i + 1]; ++k )
+            {
+                size_t position = next[indices[k]]++;
+                result.indices[position] = i;
+                result.data[position] = data[k];
+            }
+        }
+        return result;
+    }
+
+    // Values on diagonal, zero, where they aren't stored
+    std::vector<T> diagonal() const
+    {
+        std::vector<T> result( Min( width, height ), T() );
+        for( int i = 0; i < int( result.size() ); ++i )
+        {
+            const T *value = ( *this )( i, i );
+            if( value )
+                result[i] = *value;
+        }
+        return result;
+    }
+
+    MatrixBase<T> dense() const
+    {
+        MatrixBase<T> result( width, height );
+        for( int i = 0; i < height; ++i )
+        {
+            T *line = result( 0, i );
+            for( int j = 0; j < width; ++j )
+                line[j] = T();
+            for( size_t k = offsets[i]; k < offsets[i + 1]; ++k )
+                line[indices[k]] = data[k];
+        }
+        return result;
+    }
+
+    // Computes result = this * x, lines are split between threads by number of stored values
+    // 'result' must not be 'x'
+    void multiply( const std::vector<T> &x, std::vector<T> &result ) const
+    {
+        // Vector must have as many values, as matrix has columns
+        makeException( int( x.size() ) == width );
+
+        // Result must be a separate vector
+        makeException( &x != &result );
+
+        result.resize( height );
+        size_t granule = Max( SPARSE_GRANULE * size_t( height ) / Max( data.size(), size_t( 1 ) ), size_t( 1 ) );
+        parallelFor( height, [&]( size_t begin, size_t end )
+        {
+            for( size_t i = begin; i < end; ++i )
+            {
+                T sum = T();
+                for( size_t k = offsets[i]; k < offsets[i + 1]; ++k )
+                    sum += data[k] * x[indices[k]];
+                result[i] = sum;
+            }
+        }, granule );
+    }
+
+    std::vector<T> operator*( const std::vector<T> &x ) const
+    {
+        std::vector<T> result;
+        multiply( x, result );
+        return result;
+    }
+};
+
+// Preconditioner, that divides by diagonal of matrix, lines with zero diagonal are kept
+template<typename T>
+class JacobiPreconditioner
+{
+private:
+    std::vector<T> inverse;
+public:
+    explicit JacobiPreconditioner( const SparseMatrix<T> &matrix ) : inverse( matrix.diagonal() )
+    {
+        for( auto &value : inverse )
+            value = value != T() ? T( 1 ) / value : T( 1 );
+    }
+
+    // Computes result = M^-1 * r
+    void apply( const std::vector<T> &r, std::vector<T> &result ) const
+    {
+        result.resize( r.size() );
+        parallelFor( r.size(), [&]( size_t begin, size_t end )
+        {
+            for( size_t i = begin; i < end; ++i )
+                result[i] = inverse[i] * r[i];
+        }, SPARSE_GRANULE );
+    }
+};
+
+// Incomplete LU decomposition without fill: L * U has the same stored values, as matrix
+// L has units on diagonal, both are stored in values of one matrix, every line must have non-zero diagonal value
+template<typename T>
+class ILUPreconditioner
+{
+private:
+    SparseMatrix<T> lu;
+    std::vector<size_t> diagonals;
+public:
+    explicit ILUPreconditioner( const SparseMatrix<T> &matrix ) : lu( matrix )
+    {
+        // Decomposition is only defined for square matrices
+        makeException( matrix.w() == matrix.h() );
+
+        int n = lu.h();
+        diagonals.resize( n );
+
+        // Position of stored value in current line by column, or -1
+        std::vector<ptrdiff_t> positions( n, -1 );
+        for( int i = 0; i < n; ++i )
+        {
+            for( size_t k = lu.begin( i ); k < lu.end( i ); ++k )
+                positions[lu.column( k )] = k;
+
+            // Every line must have diagonal value
+            makeException( positions[i] >= 0 );
+            diagonals[i] = positions[i];
+
+            for( size_t k = lu.begin( i ); k < lu.end( i ) && lu.column( k ) < i; ++k )
+            {
+                int c = lu.column( k );
+                T factor = lu.value( k ) /= lu.value( diagonals[c] );
+                for( size_t m = diagonals[c] + 1; m < lu.end( c ); ++m )
+                {
+                    ptrdiff_t position = positions[lu.column( m )];
+                    if( position >= 0 )
+                        lu.value( position ) -= factor * lu.value( m );
+                }
+            }
+
+            // Pivot is zero, decomposition doesn't exist
+            makeException( lu.value( diagonals[i] ) != T() );
+
+            for( size_t k = lu.begin( i ); k < lu.end( i ); ++k )
+                positions[lu.column( k )] = -1;
+        }
+    }
+
+    // Computes result = ( L * U )^-1 * r by forward and back substitution
+    void apply( const std::vector<T> &r, std::vector<T> &result ) const
+    {
+        int n = lu.h();
+        result.resize( n );
+        for( int i = 0; i < n; ++i )
+        {
+            T sum = r[i];
+            for( size_t k = lu.begin( i ); k < diagonals[i]; ++k )
+                sum -= lu.value( k ) * result[lu.column( k )];
+            result[i] = sum;
+        }
+
+        for( int i = n - 1; i >= 0; --i )
+        {
+            T sum = result[i];
+            for( size_t k = diagonals[i] + 1; k < lu.end( i ); ++k )
+                sum -= lu.value( k ) * result[lu.column( k )];
+            result[i] = sum / lu.value( diagonals[i] );
+        }
+    }
+};
+
+// Preconditioner, that keeps vector unchanged
+template<typename T>
+struct IdentityPreconditioner
+{
+    void apply( const std::vector<T> &r, std::vector<T> &result ) const
+    {
+        result = r;
+    }
+};
+
+// State of iterative solver after it stops: relative residual is |b - a * x| / |b|
+template<typename T>
+struct SparseConvergence
+{
+    int iterations;
+    T residual;
+    bool converged;
+};
+
+// Operations on vectors of iterative solvers, vectors are split between threads
+template<typename T>
+struct SparseVector
+{
+    // Sums of parts are added in fixed order, so result doesn't depend on number of threads
+    static T dot( const std::vector<T> &a, const std::vector<T> &b )
+    {
+        size_t parts = ( a.size() + SPARSE_GRANULE - 1 ) / SPARSE_GRANULE;
+        std::vector<T> sums( parts, T() );
+        parallelFor( parts, [&]( size_t begin, size_t end )
+        {
+            for( size_t part = begin; part < end; ++part )
+            {
+                size_t last = Min( ( part + 1 ) * SPARSE_GRANULE, a.size() );
+                T sum = T();
+                for( size_t i = part * SPARSE_GRANULE; i < last; ++i )
+                    sum += a[i] * b[i];
+                sums[part] = sum;
+            }
+        } );
+
+        T result = T();
+        for( auto &sum : sums )
+            result += sum;
+        return result;
+    }
+
+    static T norm( const std::vector<T> &a )
+    {
+        return std::sqrt( dot( a, a ) );
+    }
+
+    // Calls 'f( i )' for every index of vectors of size 'n'
+    template<typename F>
+    static void each( size_t n, F f )
+    {
+        parallelFor( n, [&]( size_t begin, size_t end )
+        {
+            for( size_t i = begin; i < end; ++i )
+                f( i );
+        }, SPARSE_GRANULE );
+    }
+};
+
+// Checks system a * x = b and makes initial approximation zero, if 'x' doesn't have the right size
+template<typename T>
+void sparsePrepare( const SparseMatrix<T> &a, const std::vector<T> &b, std::vector<T> &x )
+{
+    // System must be square and right side must have as many values, as matrix has lines
+    makeException( a.w() == a.h() && int( b.size() ) == a.h() );
+
+    if( x.size() != b.size() )
+        x.assign( b.size(), T() );
+}
+
+// Solves a * x = b for symmetric positive definite 'a', 'x' is initial approximation
+// Stops, when relative residual doesn't exceed 'tolerance' or after 'limit' iterations
+template<typename T, typename P = IdentityPreconditioner<T>>
+SparseConvergence<T> conjugateGradient( const SparseMatrix<T> &a, const std::vector<T> &b, std::vector<T> &x,
+                                        T tolerance, int limit, const P &preconditioner = P() )
+{
+    static_assert( std::is_floating_point_v<T> );
+    using V = SparseVector<T>;
+
+    sparsePrepare( a, b, x );
+    size_t n = b.size();
+
+    T scale = V::norm( b );
+    if( scale == T() )
+    {
+        x.assign( n, T() );
+        return { 0, T(), true };
+    }
+
+    std::vector<T> r, z, p, q;
+    a.multiply( x, r );
+    V::each( n, [&]( size_t i )
+    {
+        r[i] = b[i] - r[i];
+    } );
+
+    T residual = V::norm( r ) / scale;
+    if( residual <= tolerance )
+        return { 0, residual, true };
+
+    preconditioner.apply( r, z );
+    p = z;
+    T rz = V::dot( r, z );
+
+    for( int iteration = 1; iteration <= limit; ++iteration )
+    {
+        a.multiply( p, q );
+        T pq = V::dot( p, q );
+        if( pq == T() )
+            return { iteration, residual, false };
+
+        T alpha = rz / pq;
+        V::each( n, [&]( size_t i )
+        {
+            x[i] += alpha * p[i];
+            r[i] -= alpha * q[i];
+        } );
+
+        residual = V::norm( r ) / scale;
+        if( residual <= tolerance )
+            return { iteration, residual, true };
+
+        preconditioner.apply( r, z );
+        T next = V::dot( r, z ), beta = next / rz;
+        rz = next;
+        V::each( n, [&]( size_t i )
+        {
+            p[i] = z[i] + beta * p[i];
+        } );
+    }
+    return { limit, residual, false };
+}
+
+// Solves a * x = b for any non-singular 'a', 'x' is initial approximation
+// Stops, when relative residual doesn't exceed 'tolerance', after 'limit' iterations or on breakdown
+template<typename T, typename P = IdentityPreconditioner<T>>
+SparseConvergence<T> biconjugateGradientStabilized( const SparseMatrix<T> &a, const std::vector<T> &b, std::vector<T> &x,
+                                                    T tolerance, int limit, const P &preconditioner = P() )
+{
+    static_assert( std::is_floating_point_v<T> );
+    using V = SparseVector<T>;
+
+    sparsePrepare( a, b, x );
+    size_t n = b.size();
+
+    T scale = V::norm( b );
+    if( scale == T() )
+    {
+        x.assign( n, T() );
+        return { 0, T(), true };
+    }
+
+    std::vector<T> r, shadow, p( n, T() ), v( n, T() ), y, s( n ), z, t;
+    a.multiply( x, r );
+    V::each( n, [&]( size_t i )
+    {
+        r[i] = b[i] - r[i];
+    } );
+
+    T residual = V::norm( r ) / scale;
+    if( residual <= tolerance )
+        return { 0, residual, true };
+
+    shadow = r;
+    T rho = T( 1 ), alpha = T( 1 ), omega = T( 1 );
+
+    for( int iteration = 1; iteration <= limit; ++iteration )
+    {
+        T next = V::dot( shadow, r );
+        if( next == T() || omega == T() )
+            return { iteration, residual, false };
+
+        T beta = ( next / rho ) * ( alpha / omega );
+        rho = next;
+        V::each( n, [&]( size_t i )
+        {
+            p[i] = r[i] + beta * ( p[i] - omega * v[i] );
+        } );
+
+        preconditioner.apply( p, y );
+        a.multiply( y, v );
+        T sv = V::dot( shadow, v );
+        if( sv == T() )
+            return { iteration, residual, false };
+
+        alpha = rho / sv;
+        V::each( n, [&]( size_t i )
+        {
+            s[i] = r[i] - alpha * v[i];
+        } );
+
+        residual = V::norm( s ) / scale;
+        if( residual <= tolerance )
+        {
+            V::each( n, [&]( size_t i )
+            {
+                x[i] += alpha * y[i];
+            } );
+            return { iteration, residual, true };
+        }
+
+        preconditioner.apply( s, z );
+        a.multiply( z, t );
+        T tt = V::dot( t, t );
+        omega = tt != T() ? V::dot( t, s ) / tt : T();
+        V::each( n, [&]( size_t i )
+        {
+            x[i] += alpha * y[i] + omega * z[i];
+            r[i] = s[i] - omega * t[i];
+        } );
+
+        residual = V::norm( r ) / scale;
+        if( residual <= tolerance )
+            return { iteration, residual, true };
+    }
+    return { limit, residual, false };
+}
@@ -2,6 +2,8 @@
 
 #include <optional>
 
+#include "Basic.h"
+
 class Vector2D
 {
 public:
@@ -9,35 +11,35 @@ public:
 
     double x, y;
 
-    Vector2D();
-    Vector2D( double x, double y );
-    Vector2D( const Vector2D& other );
+    constexpr Vector2D();
+    constexpr Vector2D( double x, double y );
+    Vector2D( const Vector2D& other ) = default;
 
-    Vector2D& operator=( const Vector2D& other );
+    Vector2D& operator=( const Vector2D& other ) = default;
 
-    Vector2D operator+() const;
-    Vector2D operator+( const Vector2D &a ) const;
-    Vector2D &operator+=( const Vector2D &a );
+    constexpr Vector2D operator+() const;
+    constexpr Vector2D operator+( const Vector2D &a ) const;
+    constexpr Vector2D &operator+=( const Vector2D &a );
 
-    Vector2D operator-() const;
-    Vector2D operator-( const Vector2D &a ) const;
-    Vector2D &operator-=( const Vector2D &a );
+    constexpr Vector2D operator-() const;
+    constexpr Vector2D operator-( const Vector2D &a ) const;
+    constexpr Vector2D &operator-=( const Vector2D &a );
 
-    Vector2D operator*( double k ) const;
-    Vector2D &operator*=( double k );
+    constexpr Vector2D operator*( double k ) const;
+    constexpr Vector2D &operator*=( double k );
 
-    Vector2D operator/( double k ) const;
-    Vector2D &operator/=( double k );
+    constexpr Vector2D operator/( double k ) const;
+    constexpr Vector2D &operator/=( double k );
 
-    double operator*( const Vector2D &a ) const;
+    constexpr double operator*( const Vector2D &a ) const;
 
     bool operator==( const Vector2D &a ) const;
     bool operator!=( const Vector2D &a ) const;
 
-    double M( const Vector2D &a ) const;
-    Vector2D L() const;
+    constexpr double M( const Vector2D &a ) const;
+    constexpr Vector2D L() const;
 
-    double Sqr() const;
+    constexpr double Sqr() const;
     double Abs() const;
 
     Vector2D Normal() const;
@@ -46,4 +48,131 @@ public:
     std::optional<Vector2D> IJ( const Vector2D &i, const Vector2D &j ) const;
 };
 
-Vector2D operator*( double k, const Vector2D &a );
+constexpr Vector2D operator*( double k, const Vector2D &a );
+
+constexpr Vector2D::Vector2D(): x( 0 ), y( 0 ) {}
+
+constexpr Vector2D::Vector2D( double x_, double y_ ): x( x_ ), y( y_ ) {}
+
+constexpr Vector2D Vector2D::operator+()const
+{
+    return Vector2D( +x, +y );
+}
+
+constexpr Vector2D Vector2D::operator+( const Vector2D &a ) const
+{
+    return Vector2D( x + a.x, y + a.y );
+}
+
+constexpr Vector2D &Vector2D::operator+=( const Vector2D &a )
+{
+    x += a.x;
+    y += a.y;
+    return *this;
+}
+
+constexpr Vector2D Vector2D::operator-()const
+{
+    return Vector2D( -x, -y );
+}
+
+constexpr Vector2D Vector2D::operator-( const Vector2D &a ) const
+{
+    return Vector2D( x - a.x, y - a.y );
+}
+
+constexpr Vector2D &Vector2D::operator-=( const Vector2D &a )
+{
+    x -= a.x;
+    y -= a.y;
+    return *this;
+}
+
+constexpr Vector2D Vector2D::operator*( double k ) const
+{
+    return Vector2D( x * k, y * k );
+}
+
+constexpr Vector2D &Vector2D::operator*=( double k )
+{
+    x *= k;
+    y *= k;
+    return *this;
+}
+
+constexpr Vector2D Vector2D::operator/( double k ) const
+{
+    return Vector2D( x / k, y / k );
+}
+
+constexpr Vector2D &Vector2D::operator/=( double k )
+{
+    x /= k;
+    y /= k;
+    return *this;
+}
+
+constexpr double Vector2D::operator*( const Vector2D &a ) const
+{
+    return x * a.x + y * a.y;
+}
+
+inline bool Vector2D::operator==( const Vector2D &a ) const
+{
+    return ( ::Abs( x - a.x ) <= epsilon ) && ( ::Abs( y - a.y ) <= epsilon );
+}
+
+inline bool Vector2D::operator!=( const Vector2D &a ) const
+{
+    return ( ::Abs( x - a.x ) > epsilon ) || ( ::Abs( y - a.y ) > epsilon );
+}
+
+constexpr double Vector2D::M( const Vector2D &a ) const
+{
+    return x * a.y - y * a.x;
+}
+
+constexpr Vector2D Vector2D::L() const
+{
+    return Vector2D( -y, x );
+}
+
+constexpr double Vector2D::Sqr()const
+{
+    return ( *this ) * ( *this );
+}
+
+inline double Vector2D::Abs() const
+{
+    return Sqrt( Sqr() );
+}
+
+inline Vector2D Vector2D::Normal() const
+{
+    double l = Abs();
+    if( l > 0 )
+        return ( *this ) / l;
+    return *this;
+}
+
+inline double Vector2D::Ang( const Vector2D &a ) const
+{
+    return ArcCos( Normal() * a.Normal() );
+}
+
+inline std::optional<Vector2D> Vector2D::IJ( const Vector2D &i, const Vector2D &j ) const
+{
+    double d, da, db;
+    d =  i.x * j.y - i.y * j.x;
+    da =   x * j.y -   y * j.x;
+    db = i.x *   y - i.y *   x;
+
+    if( ::Abs( d ) > epsilon * epsilon )
+        return Vector2D( da / d, db / d );
+    return {};
+}
+
+constexpr Vector2D operator*( double k, const Vector2D &a )
+{
+    return a * k;
+}
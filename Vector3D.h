@@ -1,6 +1,14 @@
 #pragma once
 
 #include <optional>
+#include <cstddef>
+
+#include "Parallel.h"
+#include "Basic.h"
+
+// Points, that are transformed together, and points, that one thread gets at least
+#define TRANSFORM_BLOCK 8
+#define TRANSFORM_GRANULE 65536
 
 class Vector3D
 {
@@ -9,34 +17,34 @@ public:
 
     double x, y, z;
 
-    Vector3D();
-    Vector3D( double x, double y, double z );
-    Vector3D( const Vector3D& other );
+    constexpr Vector3D();
+    constexpr Vector3D( double x, double y, double z );
+    Vector3D( const Vector3D& other ) = default;
 
-    Vector3D& operator=( const Vector3D& other );
+    Vector3D& operator=( const Vector3D& other ) = default;
 
-    Vector3D operator+() const;
-    Vector3D operator+( const Vector3D &a ) const;
-    Vector3D &operator+=( const Vector3D &a );
+    constexpr Vector3D operator+() const;
+    constexpr Vector3D operator+( const Vector3D &a ) const;
+    constexpr Vector3D &operator+=( const Vector3D &a );
 
-    Vector3D operator-() const;
-    Vector3D operator-( const Vector3D &a ) const;
-    Vector3D &operator-=( const Vector3D &a );
+    constexpr Vector3D operator-() const;
+    constexpr Vector3D operator-( const Vector3D &a ) const;
+    constexpr Vector3D &operator-=( const Vector3D &a );
 
-    Vector3D operator*( double k ) const;
-    Vector3D &operator*=( double k );
+    constexpr Vector3D operator*( double k ) const;
+    constexpr Vector3D &operator*=( double k );
 
-    Vector3D operator/( double k ) const;
-    Vector3D &operator/=( double k );
+    constexpr Vector3D operator/( double k ) const;
+    constexpr Vector3D &operator/=( double k );
 
-    double operator*( const Vector3D &a ) const;
+    constexpr double operator*( const Vector3D &a ) const;
 
     bool operator==( const Vector3D &a ) const;
     bool operator!=( const Vector3D &a ) const;
 
-    Vector3D M( const Vector3D &a ) const;
+    constexpr Vector3D M( const Vector3D &a ) const;
 
-    double Sqr() const;
+    constexpr double Sqr() const;
     double Abs() const;
 
     Vector3D Normal() const;
@@ -45,4 +53,189 @@ public:
     std::optional<Vector3D> IJK( const Vector3D &i, const Vector3D &j, const Vector3D &k ) const;
 };
 
-Vector3D operator*( double k, const Vector3D &a );
+constexpr Vector3D operator*( double k, const Vector3D &a );
+
+constexpr Vector3D::Vector3D(): x( 0 ), y( 0 ), z( 0 ) {}
+
+constexpr Vector3D::Vector3D( double x_, double y_, double z_ ): x( x_ ), y( y_ ), z( z_ ) {}
+
+constexpr Vector3D Vector3D::operator+()const
+{
+    return Vector3D( +x, +y, +z );
+}
+
+constexpr Vector3D Vector3D::operator+( const Vector3D &a ) const
+{
+    return Vector3D( x + a.x, y + a.y, z + a.z );
+}
+
+constexpr Vector3D &Vector3D::operator+=( const Vector3D &a )
+{
+    x += a.x;
+    y += a.y;
+    z += a.z;
+    return *this;
+}
+
+constexpr Vector3D Vector3D::operator-()const
+{
+    return Vector3D( -x, -y, -z );
+}
+
+constexpr Vector3D Vector3D::operator-( const Vector3D &a ) const
+{
+    return Vector3D( x - a.x, y - a.y, z - a.z );
+}
+
+constexpr Vector3D &Vector3D::operator-=( const Vector3D &a )
+{
+    x -= a.x;
+    y -= a.y;
+    z -= a.z;
+    return *this;
+}
+
+constexpr Vector3D Vector3D::operator*( double k ) const
+{
+    return Vector3D( x * k, y * k, z * k );
+}
+
+constexpr Vector3D &Vector3D::operator*=( double k )
+{
+    x *= k;
+    y *= k;
+    z *= k;
+    return *this;
+}
+
+constexpr Vector3D Vector3D::operator/( double k ) const
+{
+    return Vector3D( x / k, y / k, z / k );
+}
+
+constexpr Vector3D &Vector3D::operator/=( double k )
+{
+    x /= k;
+    y /= k;
+    z /= k;
+    return *this;
+}
+
+constexpr double Vector3D::operator*( const Vector3D &a ) const
+{
+    return x * a.x + y * a.y + z * a.z;
+}
+
+inline bool Vector3D::operator==( const Vector3D &a ) const
+{
+    return ( ::Abs( x - a.x ) <= epsilon ) && ( ::Abs( y - a.y ) <= epsilon ) && ( ::Abs( z - a.z ) <= epsilon );
+}
+
+inline bool Vector3D::operator!=( const Vector3D &a ) const
+{
+    return ( ::Abs( x - a.x ) > epsilon ) || ( ::Abs( y - a.y ) > epsilon ) || ( ::Abs( z - a.z ) > epsilon );
+}
+
+constexpr Vector3D Vector3D::M( const Vector3D &a ) const
+{
+    Vector3D r;
+    r.x = y * a.z - a.y * z;
+    r.y = z * a.x - a.z * x;
+    r.z = x * a.y - a.x * y;
+    return r;
+}
+
+constexpr double Vector3D::Sqr()const
+{
+    return ( *this ) * ( *this );
+}
+
+inline double Vector3D::Abs() const
+{
+    return Sqrt( Sqr() );
+}
+
+inline Vector3D Vector3D::Normal() const
+{
+    double l = Abs();
+    if( l > 0 )
+        return ( *this ) / l;
+    return *this;
+}
+
+inline double Vector3D::Ang( const Vector3D &a ) const
+{
+    return ArcCos( Normal() * a.Normal() );
+}
+
+inline std::optional<Vector3D> Vector3D::IJK( const Vector3D &i, const Vector3D &j, const Vector3D &k ) const
+{
+    double d =
+        i.x * ( j.y * k.z - j.z * k.y )
+        - i.y * ( j.x * k.z - j.z * k.x )
+        + i.z * ( j.x * k.y - j.y * k.x );
+
+    double da =
+        x   * ( j.y * k.z - j.z * k.y )
+        - y   * ( j.x * k.z - j.z * k.x )
+        + z   * ( j.x * k.y - j.y * k.x );
+
+    double db =
+        i.x * ( y * k.z -   z * k.y )
+        - i.y * ( x * k.z -   z * k.x )
+        + i.z * ( x * k.y -   y * k.x );
+
+    double dc =
+        i.x * ( j.y *    z - j.z *    y )
+        - i.y * ( j.x *    z - j.z *    x )
+        + i.z * ( j.x *    y - j.y *    x );
+
+    if( ::Abs( d ) > epsilon * epsilon * epsilon )
+        return Vector3D( da / d, db / d, dc / d );
+
+    return {};
+}
+
+constexpr Vector3D operator*( double k, const Vector3D &a )
+{
+    return a * k;
+}
+
+// Computes 'count' points of 'output' from points of 'input' on several threads, arrays may be the same
+// 'f( x, y, z, rx, ry, rz )' computes coordinates rx, ry, rz of one point from coordinates x, y, z
+// Blocks of points are split into arrays of coordinates, so loop over a block can be vectorized
+template<typename F>
+void transformPoints( const Vector3D *input, Vector3D *output, size_t count, const F &f )
+{
+    parallelFor( count, [&]( size_t begin, size_t end )
+    {
+        // Local copy can't be changed through 'output', so its values stay in registers
+        const F transform = f;
+
+        size_t i = begin;
+        for( ; i + TRANSFORM_BLOCK <= end; i += TRANSFORM_BLOCK )
+        {
+            double x[TRANSFORM_BLOCK], y[TRANSFORM_BLOCK], z[TRANSFORM_BLOCK];
+            for( int k = 0; k < TRANSFORM_BLOCK; ++k )
+            {
+                x[k] = input[i + k].x;
+                y[k] = input[i + k].y;
+                z[k] = input[i + k].z;
+            }
+
+            double rx[TRANSFORM_BLOCK], ry[TRANSFORM_BLOCK], rz[TRANSFORM_BLOCK];
+            for( int k = 0; k < TRANSFORM_BLOCK; ++k )
+                transform( x[k], y[k], z[k], rx[k], ry[k], rz[k] );
+
+            for( int k = 0; k < TRANSFORM_BLOCK; ++k )
+                output[i + k] = Vector3D( rx[k], ry[k], rz[k] );
+        }
+
+        for( ; i < end; ++i )
+        {
+            double rx, ry, rz;
+            transform( input[i].x, input[i].y, input[i].z, rx, ry, rz );
+            output[i] = Vector3D( rx, ry, rz );
+        }
+    }, TRANSFORM_GRANULE );
+}
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "Basic.h"
+
 class Vector4D
 {
 public:
@@ -7,36 +9,151 @@ public:
 
     double x, y, z, w;
 
-    Vector4D();
-    Vector4D( double x, double y, double z, double w );
-    Vector4D( const Vector4D& other );
+    constexpr Vector4D();
+    constexpr Vector4D( double x, double y, double z, double w );
+    Vector4D( const Vector4D& other ) = default;
 
-    Vector4D& operator=( const Vector4D& other );
+    Vector4D& operator=( const Vector4D& other ) = default;
 
-    Vector4D operator+() const;
-    Vector4D operator+( const Vector4D &a ) const;
-    Vector4D &operator+=( const Vector4D &a );
+    constexpr Vector4D operator+() const;
+    constexpr Vector4D operator+( const Vector4D &a ) const;
+    constexpr Vector4D &operator+=( const Vector4D &a );
 
-    Vector4D operator-() const;
-    Vector4D operator-( const Vector4D &a ) const;
-    Vector4D &operator-=( const Vector4D &a );
+    constexpr Vector4D operator-() const;
+    constexpr Vector4D operator-( const Vector4D &a ) const;
+    constexpr Vector4D &operator-=( const Vector4D &a );
 
-    Vector4D operator*( double k ) const;
-    Vector4D &operator*=( double k );
+    constexpr Vector4D operator*( double k ) const;
+    constexpr Vector4D &operator*=( double k );
 
-    Vector4D operator/( double k ) const;
-    Vector4D &operator/=( double k );
+    constexpr Vector4D operator/( double k ) const;
+    constexpr Vector4D &operator/=( double k );
 
-    double operator*( const Vector4D &a ) const;
+    constexpr double operator*( const Vector4D &a ) const;
 
     bool operator==( const Vector4D &a ) const;
     bool operator!=( const Vector4D &a ) const;
 
-    double Sqr() const;
+    constexpr double Sqr() const;
     double Abs() const;
 
     Vector4D Normal() const;
     double Ang( const Vector4D &a ) const;
 };
 
-Vector4D operator*( double k, const Vector4D &a );
+constexpr Vector4D operator*( double k, const Vector4D &a );
+
+constexpr Vector4D::Vector4D(): x( 0 ), y( 0 ), z( 0 ), w( 0 ) {}
+
+constexpr Vector4D::Vector4D( double x_, double y_, double z_, double w_ ): x( x_ ), y( y_ ), z( z_ ), w( w_ ) {}
+
+constexpr Vector4D Vector4D::operator+() const
+{
+    return Vector4D( +x, +y, +z, +w );
+}
+
+constexpr Vector4D Vector4D::operator+( const Vector4D &a ) const
+{
+    return Vector4D( x + a.x, y + a.y, z + a.z, w + a.w );
+}
+
+constexpr Vector4D &Vector4D::operator+=( const Vector4D &a )
+{
+    x += a.x;
+    y += a.y;
+    z += a.z;
+    w += a.w;
+    return *this;
+}
+
+constexpr Vector4D Vector4D::operator-() const
+{
+    return Vector4D( -x, -y, -z, -w );
+}
+
+constexpr Vector4D Vector4D::operator-( const Vector4D &a ) const
+{
+    return Vector4D( x - a.x, y - a.y, z - a.z, w - a.w );
+}
+
+constexpr Vector4D &Vector4D::operator-=( const Vector4D &a )
+{
+    x -= a.x;
+    y -= a.y;
+    z -= a.z;
+    w -= a.w;
+    return *this;
+}
+
+constexpr Vector4D Vector4D::operator*( double k ) const
+{
+    return Vector4D( x * k, y * k, z * k, w * k );
+}
+
+constexpr Vector4D &Vector4D::operator*=( double k )
+{
+    x *= k;
+    y *= k;
+    z *= k;
+    w *= k;
+    return *this;
+}
+
+constexpr Vector4D Vector4D::operator/( double k ) const
+{
+    return Vector4D( x / k, y / k, z / k, w / k );
+}
+
+constexpr Vector4D &Vector4D::operator/=( double k )
+{
+    x /= k;
+    y /= k;
+    z /= k;
+    w /= k;
+    return *this;
+}
+
+constexpr double Vector4D::operator*( const Vector4D &a ) const
+{
+    return x * a.x + y * a.y + z * a.z + w * a.w;
+}
+
+inline bool Vector4D::operator==( const Vector4D &a ) const
+{
+    return ( ::Abs( x - a.x ) <= epsilon ) && ( ::Abs( y - a.y ) <= epsilon )
+           && ( ::Abs( z - a.z ) <= epsilon ) && ( ::Abs( w - a.w ) <= epsilon );
+}
+
+inline bool Vector4D::operator!=( const Vector4D &a ) const
+{
+    return ( ::Abs( x - a.x ) > epsilon ) || ( ::Abs( y - a.y ) > epsilon )
+           || ( ::Abs( z - a.z ) > epsilon ) || ( ::Abs( w - a.w ) > epsilon );
+}
+
+constexpr double Vector4D::Sqr() const
+{
+    return ( *this ) * ( *this );
+}
+
+inline double Vector4D::Abs() const
+{
+    return Sqrt( Sqr() );
+}
+
+inline Vector4D Vector4D::Normal() const
+{
+    double l = Abs();
+    if( l > 0 )
+        return ( *this ) / l;
+    return *this;
+}
+
+inline double Vector4D::Ang( const Vector4D &a ) const
+{
+    return ArcCos( Normal() * a.Normal() );
+}
+
+constexpr Vector4D operator*( double k, const Vector4D &a )
+{
+    return a * k;
+}